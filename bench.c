@@ -0,0 +1,368 @@
+/*
+   bench.c - microbenchmarks do núcleo do PROJETO WAR ESTRUTURADO.
+
+   Uso: bench [--tamanhos 42,1000,100000] [--amostras N] [--alvo-ms N]
+              [--semente N] [--filtro NOME] [--saida ARQ]
+
+   Mede, para cada tamanho de mapa:
+   - inicializarTerritorios  (um mapa inteiro por operação)
+   - simularAtaque           (validar + sortear dados + resolverBatalha, sem E/S,
+                              com o desfazer pelo diário amortizado)
+   - verificarVitoria        (alternando os três tipos de missão)
+   - sortearMissao           (missão na arena, como no executor paralelo)
+   - partidaCompleta         (jogarPartidaAutomatica do início ao fim)
+   Cada medida é calibrada para que uma amostra dure ao menos --alvo-ms e
+   repetida --amostras vezes. A tabela legível vai para stderr; o JSON
+   (ns/op: mín, média, p50, p90, p99, máx; ops/s) vai para stdout ou --saida.
+*/
+
+#include "war.h"
+
+#define BENCH_MAX_AMOSTRAS 1000
+#define BENCH_MAX_TAMANHOS 16
+#define BENCH_MAX_OPS_AMOSTRA (1LL << 30)
+
+/* Uma operação medida: 'executar' roda 'ops' operações sobre 'ctx';
+   'restaurar' (opcional, fora da medição) devolve o estado inicial. */
+typedef struct {
+    const char *nome;
+    void (*executar)(void *ctx, long long ops);
+    void (*restaurar)(void *ctx);
+    void *ctx;
+} OperacaoBench;
+
+/* Resultado de uma operação em um tamanho de mapa */
+typedef struct {
+    long long opsPorAmostra;
+    int amostras;
+    double min, media, p50, p90, p99, max;  /* ns por operação */
+} MedidaBench;
+
+/* Evita que o compilador descarte resultados não usados */
+static volatile long long sumidouro;
+
+static char coresBench[MAX_CORES][TAM_COR] = { "Azul", "Vermelho", "Verde", "Amarelo", "Preto", "Branco" };
+
+/* --- inicializarTerritorios --- */
+typedef struct {
+    Mapa *mapa;
+    GeradorAleatorio rng;
+} CtxInicializar;
+
+static void opInicializar(void *arg, long long ops) {
+    CtxInicializar *c = (CtxInicializar*) arg;
+    for (long long k = 0; k < ops; ++k)
+        inicializarTerritorios(c->mapa, coresBench, 2, &c->rng);
+}
+
+/* --- simularAtaque (caminho sem E/S) --- */
+typedef struct {
+    Mapa *mapa;
+    Diario diario;
+    GeradorAleatorio rng;
+    int *origens, *destinos;
+    uint8_t *cores;         /* cor que ataca em cada par (dono da origem no início) */
+    int numPares;
+    int proximo;
+} CtxAtaque;
+
+/* Cada passada pelos pares ataca o mapa inicial: ao fim dela o diário
+   desfaz tudo (custo amortizado incluído na medida), senão as origens se
+   esgotariam e só o caminho de recusa seria medido. */
+static void opAtaque(void *arg, long long ops) {
+    CtxAtaque *c = (CtxAtaque*) arg;
+    long long validos = 0;
+    for (long long k = 0; k < ops; ++k) {
+        int p = c->proximo;
+        validos += executarAtaqueJogador(c->mapa, c->cores[p], c->origens[p], c->destinos[p], &c->rng, 0) == ATAQUE_OK;
+        if (++c->proximo == c->numPares) {
+            c->proximo = 0;
+            desfazerAte(c->mapa, 0);
+        }
+    }
+    sumidouro += validos;
+}
+
+/* volta ao mapa inicial entre amostras */
+static void restaurarAtaque(void *arg) {
+    CtxAtaque *c = (CtxAtaque*) arg;
+    desfazerAte(c->mapa, 0);
+    c->proximo = 0;
+}
+
+/* --- verificarVitoria --- */
+typedef struct {
+    const Mapa *mapa;
+    Missao missoes[3];
+} CtxVitoria;
+
+static void opVitoria(void *arg, long long ops) {
+    CtxVitoria *c = (CtxVitoria*) arg;
+    long long cumpridas = 0;
+    for (long long k = 0; k < ops; ++k)
+        cumpridas += verificarVitoria(c->mapa, &c->missoes[k % 3], 0);
+    sumidouro += cumpridas;
+}
+
+/* --- sortearMissao --- */
+typedef struct {
+    const Mapa *mapa;
+    Arena arena;
+    GeradorAleatorio rng;
+} CtxMissao;
+
+static void opMissao(void *arg, long long ops) {
+    CtxMissao *c = (CtxMissao*) arg;
+    size_t marca = arenaMarca(&c->arena);
+    long long tipos = 0;
+    for (long long k = 0; k < ops; ++k) {
+        Missao *m = sortearMissao(c->mapa, 0, &c->rng, &c->arena);
+        if (!m) {
+            /* sem missão não há o que medir: um número parcial enganaria */
+            fprintf(stderr, "sortearMissao falhou (arena esgotada); benchmark interrompido.\n");
+            exit(1);
+        }
+        tipos += m->tipo;
+        arenaRestaurar(&c->arena, marca);
+    }
+    sumidouro += tipos;
+}
+
+/* --- partida completa --- */
+typedef struct {
+    int qtd;
+    const Grafo *grafo;
+    Arena arena;
+    GeradorAleatorio rng;
+    EstatisticaPartidas est;
+} CtxPartida;
+
+static void opPartida(void *arg, long long ops) {
+    CtxPartida *c = (CtxPartida*) arg;
+    for (long long k = 0; k < ops; ++k) {
+        arenaReiniciar(&c->arena);
+        Mapa *mapa = alocarMapaArena(&c->arena, c->qtd, 0);
+        mapa->grafo = c->grafo;
+        jogarPartidaAutomatica(mapa, coresBench, 2, &c->rng, &c->arena, &c->est);
+    }
+    sumidouro += c->est.vitorias;
+}
+
+/* compararDouble():
+   Ordem crescente para qsort.
+*/
+static int compararDouble(const void *a, const void *b) {
+    double x = *(const double*) a, y = *(const double*) b;
+    return (x > y) - (x < y);
+}
+
+/* percentil():
+   Percentil p (0..100) de um vetor ordenado, pelo posto mais próximo.
+*/
+static double percentil(const double *ordenado, int n, double p) {
+    int posto = (int) ceil(p / 100.0 * n);
+    if (posto < 1) posto = 1;
+    if (posto > n) posto = n;
+    return ordenado[posto - 1];
+}
+
+/* medirOperacao():
+   Calibra quantas operações cabem em uma amostra de ao menos 'alvo' segundos
+   (dobrando a partir de 1), depois mede 'amostras' amostras e resume o ns/op.
+*/
+static void medirOperacao(const OperacaoBench *op, int amostras, double alvo, MedidaBench *m) {
+    double nsPorOp[BENCH_MAX_AMOSTRAS];
+    long long ops = 1;
+    for (;;) {
+        double inicio = segundosMonotonicos();
+        op->executar(op->ctx, ops);
+        double decorrido = segundosMonotonicos() - inicio;
+        if (op->restaurar) op->restaurar(op->ctx);
+        if (decorrido >= alvo || ops >= BENCH_MAX_OPS_AMOSTRA) break;
+        ops *= 2;
+    }
+
+    double soma = 0.0;
+    for (int a = 0; a < amostras; ++a) {
+        double inicio = segundosMonotonicos();
+        op->executar(op->ctx, ops);
+        double decorrido = segundosMonotonicos() - inicio;
+        if (op->restaurar) op->restaurar(op->ctx);
+        nsPorOp[a] = decorrido * 1e9 / (double) ops;
+        soma += nsPorOp[a];
+    }
+    qsort(nsPorOp, (size_t) amostras, sizeof(double), compararDouble);
+
+    m->opsPorAmostra = ops;
+    m->amostras = amostras;
+    m->min = nsPorOp[0];
+    m->max = nsPorOp[amostras - 1];
+    m->media = soma / amostras;
+    m->p50 = percentil(nsPorOp, amostras, 50);
+    m->p90 = percentil(nsPorOp, amostras, 90);
+    m->p99 = percentil(nsPorOp, amostras, 99);
+}
+
+/* registrarMedida():
+   Imprime uma linha da tabela (stderr) e um objeto do vetor JSON.
+*/
+static void registrarMedida(FILE *json, int *primeiro, const char *nome, int qtd, const MedidaBench *m) {
+    double opsPorSegundo = m->media > 0 ? 1e9 / m->media : 0.0;
+    fprintf(stderr, "%-24s %-10d %-12.1f %-12.1f %-12.1f %-12.1f %-14.0f\n",
+            nome, qtd, m->media, m->p50, m->p90, m->p99, opsPorSegundo);
+    fprintf(json, "%s\n    {\"nome\": \"%s\", \"territorios\": %d, \"amostras\": %d, \"ops_por_amostra\": %lld, "
+            "\"ns_por_op\": {\"min\": %.3f, \"media\": %.3f, \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"max\": %.3f}, "
+            "\"ops_por_segundo\": %.1f}",
+            *primeiro ? "" : ",", nome, qtd, m->amostras, m->opsPorAmostra,
+            m->min, m->media, m->p50, m->p90, m->p99, m->max, opsPorSegundo);
+    *primeiro = 0;
+}
+
+/* lerTamanhos():
+   Converte "42,1000,100000" em um vetor de tamanhos. Retorna a quantidade
+   (0 se a lista for inválida).
+*/
+static int lerTamanhos(const char *texto, int *tamanhos) {
+    int n = 0;
+    while (*texto && n < BENCH_MAX_TAMANHOS) {
+        char *fim;
+        long v = strtol(texto, &fim, 10);
+        if (fim == texto || v < 2 || v > INT32_MAX) return 0;
+        tamanhos[n++] = (int) v;
+        texto = (*fim == ',') ? fim + 1 : fim;
+        if (*fim && *fim != ',') return 0;
+    }
+    return n;
+}
+
+/* medirTamanho():
+   Prepara os contextos para mapas de 'qtd' territórios (grade de fronteiras)
+   e mede as operações selecionadas pelo filtro. Retorna 0 ou -1 se faltar memória.
+*/
+static int medirTamanho(int qtd, uint64_t semente, int amostras, double alvo, const char *filtro,
+                        FILE *json, int *primeiro) {
+    GeradorAleatorio rng;
+    rngSemear(&rng, semente);
+    Grafo *grafo = gerarGrafoGrade(qtd);
+    Mapa *mapa = alocarMapa(qtd, 0);
+    CtxAtaque ataque;
+    memset(&ataque, 0, sizeof(ataque));
+    ataque.origens = (int*) memAlocar((size_t) qtd * sizeof(int));
+    ataque.destinos = (int*) memAlocar((size_t) qtd * sizeof(int));
+    ataque.cores = (uint8_t*) memAlocar((size_t) qtd * sizeof(uint8_t));
+    CtxMissao missao;
+    CtxPartida partida;
+    memset(&missao, 0, sizeof(missao));
+    memset(&partida, 0, sizeof(partida));
+    int erro = !grafo || !mapa || !ataque.origens || !ataque.destinos || !ataque.cores ||
+               diarioCriar(&ataque.diario, 1024) != 0 ||
+               arenaCriar(&missao.arena, 4096) != 0 ||
+               arenaCriar(&partida.arena, tamanhoArenaPartida(qtd, 0)) != 0;
+
+    if (!erro) {
+        mapa->grafo = grafo;
+        inicializarTerritorios(mapa, coresBench, 2, &rng);
+
+        /* pares de ataque válidos no mapa inicial: cada origem com 2+ tropas
+           contra o primeiro vizinho inimigo */
+        for (int i = 0; i < qtd; ++i) {
+            if (mapa->tropas[i] < 2) continue;
+            for (int64_t e = grafo->inicio[i]; e < grafo->inicio[i + 1]; ++e) {
+                int d = grafo->vizinhos[e];
+                if (mapa->dono[d] == mapa->dono[i]) continue;
+                ataque.origens[ataque.numPares] = i;
+                ataque.destinos[ataque.numPares] = d;
+                ataque.cores[ataque.numPares] = mapa->dono[i];
+                ataque.numPares++;
+                break;
+            }
+        }
+
+        CtxInicializar inicializar = { alocarMapa(qtd, 0), rng };
+        ataque.mapa = mapa;
+        ataque.rng = rngDividir(&rng);
+        CtxVitoria vitoria = { mapa, { { 0 } } };
+        montarMissaoPadrao(&vitoria.missoes[0], MISSao_CONQUISTAR_N, qtd / 3, COR_NENHUMA);
+        montarMissaoPadrao(&vitoria.missoes[1], MISSao_DESTRUIR_COR, 0, 1);
+        montarMissaoPadrao(&vitoria.missoes[2], MISSao_REUNIR_TROPAS, qtd, COR_NENHUMA);
+        missao.mapa = mapa;
+        missao.rng = rngDividir(&rng);
+        partida.qtd = qtd;
+        partida.grafo = grafo;
+        partida.rng = rngDividir(&rng);
+
+        OperacaoBench ops[] = {
+            { "inicializarTerritorios", opInicializar, NULL, &inicializar },
+            { "simularAtaque", opAtaque, restaurarAtaque, &ataque },
+            { "verificarVitoria", opVitoria, NULL, &vitoria },
+            { "sortearMissao", opMissao, NULL, &missao },
+            { "partidaCompleta", opPartida, NULL, &partida },
+        };
+        erro = !inicializar.mapa;
+        for (size_t k = 0; !erro && k < sizeof(ops) / sizeof(ops[0]); ++k) {
+            if (filtro && !strstr(ops[k].nome, filtro)) continue;
+            if (ops[k].executar == opAtaque) {
+                if (ataque.numPares == 0) continue;
+                mapa->diario = &ataque.diario;
+            }
+            MedidaBench m;
+            medirOperacao(&ops[k], amostras, alvo, &m);
+            mapa->diario = NULL;
+            if (ataque.diario.incompleto) {
+                fprintf(stderr, "Falta de memória para o diário de simularAtaque.\n");
+                erro = 1;
+                break;
+            }
+            registrarMedida(json, primeiro, ops[k].nome, qtd, &m);
+        }
+        liberarMemoria(inicializar.mapa, NULL);
+    }
+
+    diarioLiberar(&ataque.diario);
+    free(ataque.origens);
+    free(ataque.destinos);
+    free(ataque.cores);
+    arenaDestruir(&missao.arena);
+    arenaDestruir(&partida.arena);
+    liberarMemoria(mapa, NULL);
+    liberarGrafo(grafo);
+    return erro ? -1 : 0;
+}
+
+int main(int argc, char *argv[]) {
+    int tamanhos[BENCH_MAX_TAMANHOS];
+    int numTamanhos = lerTamanhos(lerOpcaoTexto(argc, argv, "--tamanhos", "42,1000,100000"), tamanhos);
+    int amostras = (int) lerOpcaoInteira(argc, argv, "--amostras", 30);
+    double alvo = (double) lerOpcaoInteira(argc, argv, "--alvo-ms", 5) / 1e3;
+    uint64_t semente = (uint64_t) lerOpcaoInteira(argc, argv, "--semente", 1);
+    const char *filtro = lerOpcaoTexto(argc, argv, "--filtro", NULL);
+    const char *saida = lerOpcaoTexto(argc, argv, "--saida", NULL);
+    INSTR_CONFIGURAR(argc, argv);
+
+    if (numTamanhos == 0 || amostras < 1 || amostras > BENCH_MAX_AMOSTRAS || alvo <= 0) {
+        fprintf(stderr, "Uso: %s [--tamanhos 42,1000,100000] [--amostras 1..%d] [--alvo-ms N] "
+                "[--semente N] [--filtro NOME] [--saida ARQ]\n", argv[0], BENCH_MAX_AMOSTRAS);
+        return 1;
+    }
+
+    FILE *json = saida ? fopen(saida, "w") : stdout;
+    if (!json) {
+        perror("Falha ao criar o arquivo de saída");
+        return 1;
+    }
+
+    fprintf(stderr, "%-24s %-10s %-12s %-12s %-12s %-12s %-14s\n",
+            "OPERAÇÃO", "TERRIT.", "NS/OP", "P50", "P90", "P99", "OPS/s");
+    fprintf(json, "{\n  \"semente\": %llu,\n  \"amostras\": %d,\n  \"alvo_ms\": %.3f,\n  \"resultados\": [",
+            (unsigned long long) semente, amostras, alvo * 1e3);
+    int primeiro = 1, erro = 0;
+    for (int t = 0; t < numTamanhos && !erro; ++t) {
+        if (medirTamanho(tamanhos[t], semente, amostras, alvo, filtro, json, &primeiro) != 0) {
+            fprintf(stderr, "Falha na alocação de memória para %d territórios.\n", tamanhos[t]);
+            erro = 1;
+        }
+    }
+    fprintf(json, "\n  ]\n}\n");
+    if (saida) fclose(json);
+    return erro;
+}
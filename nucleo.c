@@ -0,0 +1,5019 @@
+/*
+   nucleo.c - implementação do núcleo do PROJETO WAR ESTRUTURADO (libwar.a):
+   gerador aleatório, mapa e agregados, batalhas, missões, grafo de
+   fronteiras, snapshot, renderização, IA e os modos não interativos.
+   O programa do jogo (main) fica em war.c.
+*/
+
+#include "war.h"
+
+/* ========================= IMPLEMENTAÇÃO DAS FUNÇÕES ========================= */
+
+/* rngSemear():
+   Inicializa o estado do xoshiro256** a partir de uma semente de 64 bits,
+   expandida com splitmix64 (evita estados ruins como todo zero).
+*/
+void rngSemear(GeradorAleatorio *rng, uint64_t semente) {
+    uint64_t z = semente;
+    for (int i = 0; i < 4; ++i) {
+        z += 0x9E3779B97F4A7C15ULL;
+        uint64_t x = z;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        rng->s[i] = x ^ (x >> 31);
+    }
+}
+
+/* rngSemearFluxo():
+   Deriva o fluxo independente 'fluxo' de uma mesma semente. Usado para dar a
+   cada par/jogo/thread a sua própria sequência, reprodutível e independente
+   da ordem de execução.
+*/
+void rngSemearFluxo(GeradorAleatorio *rng, uint64_t semente, uint64_t fluxo) {
+    uint64_t x = fluxo + 0x632BE59BD9B4E019ULL;
+    x = (x ^ (x >> 33)) * 0xFF51AFD7ED558CCDULL;
+    x = (x ^ (x >> 33)) * 0xC4CEB9FE1A85EC53ULL;
+    rngSemear(rng, semente ^ x ^ (x >> 33));
+}
+
+/* rngSaltar():
+   Avança o gerador 2^128 passos (função jump do xoshiro256**).
+*/
+void rngSaltar(GeradorAleatorio *rng) {
+    static const uint64_t SALTO[4] = {
+        0x180EC6D33CFD0ABAULL, 0xD5A61266F0C9392CULL,
+        0xA9582618E03FC9AAULL, 0x39ABDC4529B1661CULL
+    };
+    uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    for (int i = 0; i < 4; ++i) {
+        for (int b = 0; b < 64; ++b) {
+            if (SALTO[i] & (1ULL << b)) {
+                s0 ^= rng->s[0]; s1 ^= rng->s[1]; s2 ^= rng->s[2]; s3 ^= rng->s[3];
+            }
+            rngProximo(rng);
+        }
+    }
+    rng->s[0] = s0; rng->s[1] = s1; rng->s[2] = s2; rng->s[3] = s3;
+}
+
+/* rngDividir():
+   Retorna um novo gerador com o estado atual e salta o original 2^128 passos,
+   garantindo que as duas sequências nunca se sobreponham.
+*/
+GeradorAleatorio rngDividir(GeradorAleatorio *rng) {
+    GeradorAleatorio filho = *rng;
+    rngSaltar(rng);
+    return filho;
+}
+
+/* rngProximo():
+   Próximo valor de 64 bits do xoshiro256**.
+*/
+uint64_t rngProximo(GeradorAleatorio *rng) {
+    uint64_t *s = rng->s;
+    uint64_t x = s[1] * 5;
+    uint64_t resultado = ((x << 7) | (x >> 57)) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = (s[3] << 45) | (s[3] >> 19);
+    return resultado;
+}
+
+/* rngIntervalo():
+   Inteiro uniforme em [0, n) sem viés de módulo (método de Lemire:
+   multiplicação 32x32 -> 64 com rejeição rara).
+*/
+uint32_t rngIntervalo(GeradorAleatorio *rng, uint32_t n) {
+    uint64_t m = (uint64_t) (uint32_t) (rngProximo(rng) >> 32) * n;
+    uint32_t baixo = (uint32_t) m;
+    if (baixo < n) {
+        uint32_t limite = (uint32_t) (-n) % n;
+        while (baixo < limite) {
+            m = (uint64_t) (uint32_t) (rngProximo(rng) >> 32) * n;
+            baixo = (uint32_t) m;
+        }
+    }
+    return (uint32_t) (m >> 32);
+}
+
+/* rngDado():
+   Rola um dado de 6 faces (1..6) sem viés.
+*/
+int rngDado(GeradorAleatorio *rng) {
+    return (int) rngIntervalo(rng, 6) + 1;
+}
+
+/* memAlocar() / memAlocarZerado() / memRealocar():
+   malloc/calloc/realloc do núcleo do jogo com contador global de alocações,
+   usado pelos benchmarks para comprovar que não há alocação por partida
+   (cada crescimento por memRealocar() conta como uma alocação).
+*/
+static _Atomic long long contadorAlocacoes = 0;
+
+void* memAlocar(size_t tam) {
+    atomic_fetch_add_explicit(&contadorAlocacoes, 1, memory_order_relaxed);
+    return malloc(tam);
+}
+
+void* memAlocarZerado(size_t n, size_t tam) {
+    atomic_fetch_add_explicit(&contadorAlocacoes, 1, memory_order_relaxed);
+    return calloc(n, tam);
+}
+
+void* memRealocar(void *ptr, size_t tam) {
+    atomic_fetch_add_explicit(&contadorAlocacoes, 1, memory_order_relaxed);
+    return realloc(ptr, tam);
+}
+
+/* alocacoesHeap():
+   Total de alocações feitas por memAlocar()/memAlocarZerado()/memRealocar() até agora.
+*/
+long long alocacoesHeap(void) {
+    return atomic_load_explicit(&contadorAlocacoes, memory_order_relaxed);
+}
+
+/* arenaCriar():
+   Reserva o bloco da arena (uma única alocação). Retorna 0 ou -1 se faltar memória.
+*/
+int arenaCriar(Arena *arena, size_t capacidade) {
+    arena->base = (uint8_t*) memAlocar(capacidade);
+    arena->capacidade = arena->base ? capacidade : 0;
+    arena->usado = 0;
+    return arena->base ? 0 : -1;
+}
+
+/* arenaAlocar():
+   Reserva 'tam' bytes alinhados a 64 (linha de cache) ou NULL se não couber.
+   A memória não é zerada.
+*/
+void* arenaAlocar(Arena *arena, size_t tam) {
+    size_t inicio = (arena->usado + 63) & ~(size_t) 63;
+    if (inicio > arena->capacidade || tam > arena->capacidade - inicio) return NULL;
+    arena->usado = inicio + tam;
+    return arena->base + inicio;
+}
+
+/* arenaMarca() / arenaRestaurar():
+   Guardam e restauram o cursor, para liberar de uma vez buffers temporários.
+*/
+size_t arenaMarca(const Arena *arena) {
+    return arena->usado;
+}
+
+void arenaRestaurar(Arena *arena, size_t marca) {
+    arena->usado = marca;
+}
+
+/* arenaReiniciar():
+   Recicla toda a arena em O(1) (entre partidas).
+*/
+void arenaReiniciar(Arena *arena) {
+    arena->usado = 0;
+}
+
+/* arenaDestruir():
+   Devolve o bloco da arena ao sistema.
+*/
+void arenaDestruir(Arena *arena) {
+    free(arena->base);
+    arena->base = NULL;
+    arena->capacidade = arena->usado = 0;
+}
+
+/* tamanhoArenaPartida():
+   Capacidade de arena suficiente para uma partida de 'qtd' territórios:
+   mapa, missão e o rascunho de analisarComponentes(), com folga de alinhamento.
+*/
+size_t tamanhoArenaPartida(int qtd, int comNomes) {
+    size_t n = (size_t) qtd;
+    size_t mapa = sizeof(Mapa) + n * (sizeof(uint8_t) + sizeof(int) + (comNomes ? TAM_NOME : 0));
+    size_t rascunho = n * sizeof(int) + n / 8 + 1;
+    return mapa + sizeof(Missao) + rascunho + 8 * 64;
+}
+
+/* alocarMapaArena():
+   Como alocarMapa(), mas tudo sai da arena (sem chamar o alocador). Apenas a
+   struct é zerada: dono/tropas/nomes são preenchidos por inicializarTerritorios().
+   Mapas da arena não devem ser passados a liberarMemoria().
+*/
+Mapa* alocarMapaArena(Arena *arena, int qtd, int comNomes) {
+    Mapa *mapa = (Mapa*) arenaAlocar(arena, sizeof(Mapa));
+    if (!mapa) return NULL;
+    memset(mapa, 0, sizeof(*mapa));
+
+    mapa->qtd = qtd;
+    mapa->dono = (uint8_t*) arenaAlocar(arena, (size_t) qtd * sizeof(uint8_t));
+    mapa->tropas = (int*) arenaAlocar(arena, (size_t) qtd * sizeof(int));
+    if (comNomes)
+        mapa->nomes = (char (*)[TAM_NOME]) arenaAlocar(arena, (size_t) qtd * TAM_NOME);
+
+    if (!mapa->dono || !mapa->tropas || (comNomes && !mapa->nomes)) return NULL;
+    return mapa;
+}
+
+/* alocarMapa():
+   Aloca dinamicamente o mapa e seus vetores paralelos (dono, tropas e,
+   se comNomes, o vetor frio de nomes) usando calloc.
+   Retorna ponteiro para o mapa ou NULL em caso de falha.
+*/
+Mapa* alocarMapa(int qtd, int comNomes) {
+    Mapa *mapa = (Mapa*) memAlocarZerado(1, sizeof(Mapa));
+    if (!mapa) return NULL;
+
+    mapa->qtd = qtd;
+    mapa->dono = (uint8_t*) memAlocarZerado((size_t)qtd, sizeof(uint8_t));
+    mapa->tropas = (int*) memAlocarZerado((size_t)qtd, sizeof(int));
+    if (comNomes)
+        mapa->nomes = (char (*)[TAM_NOME]) memAlocarZerado((size_t)qtd, TAM_NOME);
+
+    if (!mapa->dono || !mapa->tropas || (comNomes && !mapa->nomes)) {
+        liberarMemoria(mapa, NULL);
+        return NULL;
+    }
+    return mapa;
+}
+
+/* inicializarTerritorios():
+   Preenche os dados iniciais de cada território no mapa (nome, cor e tropas).
+   Interna as primeiras numCores cores do vetor cores[] e as atribui de forma
+   alternada. Esta função modifica o mapa passado por referência (ponteiro).
+*/
+void inicializarTerritorios(Mapa *mapa, char cores[][TAM_COR], int numCores, GeradorAleatorio *rng) {
+    uint8_t ids[MAX_CORES];
+    for (int c = 0; c < numCores; ++c)
+        ids[c] = (uint8_t) internarCor(mapa, cores[c]);
+
+    memset(mapa->territoriosPorCor, 0, sizeof(mapa->territoriosPorCor));
+    memset(mapa->tropasPorCor, 0, sizeof(mapa->tropasPorCor));
+
+    for (int i = 0, idxCor = 0; i < mapa->qtd; ++i) {
+        if (mapa->nomes)
+            snprintf(mapa->nomes[i], TAM_NOME, "Territorio_%d", i);
+        /* alterna cor para distribuir inicialmente */
+        mapa->dono[i] = ids[idxCor];
+        /* tropas iniciais aleatórias entre 2 e 6 */
+        mapa->tropas[i] = (int) rngIntervalo(rng, 5) + 2;
+
+        mapa->territoriosPorCor[ids[idxCor]]++;
+        mapa->tropasPorCor[ids[idxCor]] += mapa->tropas[i];
+        if (++idxCor == numCores) idxCor = 0;
+    }
+}
+
+/* diarioRegistrar():
+   Empilha o estado anterior de um território. Um diário com buffer fixo que
+   transborda é erro de dimensionamento do chamador: aborta, como
+   conferirAgregados(), em vez de perder silenciosamente o desfazer. Se falta
+   memória para o diário do heap crescer, o registro se perde e o diário
+   fica marcado como 'incompleto' para o chamador conferir.
+*/
+static void diarioRegistrar(Diario *diario, int idx, int dono, int tropas) {
+    if (diario->qtd == diario->capacidade) {
+        if (!diario->proprio) {
+            fprintf(stderr, "Diário de jogadas cheio (%zu registros).\n", diario->capacidade);
+            abort();
+        }
+        size_t nova = diario->capacidade ? diario->capacidade * 2 : 1024;
+        RegistroDiario *regs = (RegistroDiario*) memRealocar(diario->registros, nova * sizeof(RegistroDiario));
+        if (!regs) {
+            diario->incompleto = 1;
+            return;
+        }
+        diario->registros = regs;
+        diario->capacidade = nova;
+    }
+    diario->registros[diario->qtd++] = (RegistroDiario) { idx, (uint8_t) dono, tropas };
+}
+
+/* aplicarMutacao():
+   Troca dono e tropas do território idx e lança a diferença nos agregados
+   'territorios'/'tropas' (os do mapa, ou os deltas de uma thread do lote).
+   É a única escrita em dono/tropas durante o jogo: atualizarTerritorio() e
+   resolverFatiaLote() passam por aqui.
+*/
+static inline void aplicarMutacao(Mapa *mapa, long long *territorios, long long *tropas,
+                                  int idx, int dono, int tropasNovas) {
+    int donoAntigo = mapa->dono[idx];
+    territorios[donoAntigo]--;
+    tropas[donoAntigo] -= mapa->tropas[idx];
+
+    mapa->dono[idx] = (uint8_t) dono;
+    mapa->tropas[idx] = tropasNovas;
+    territorios[dono]++;
+    tropas[dono] += tropasNovas;
+}
+
+/* atualizarTerritorio():
+   Caminho de mutação do mapa durante o jogo: troca dono e tropas do
+   território idx e ajusta os agregados por cor em O(1). Com um diário ligado,
+   anota antes o estado anterior para desfazerAte().
+*/
+void atualizarTerritorio(Mapa *mapa, int idx, int dono, int tropas) {
+    if (mapa->diario) diarioRegistrar(mapa->diario, idx, mapa->dono[idx], mapa->tropas[idx]);
+    aplicarMutacao(mapa, mapa->territoriosPorCor, mapa->tropasPorCor, idx, dono, tropas);
+}
+
+/* diarioCriar():
+   Diário no heap com capacidade inicial 'capacidade' (cresce sob demanda).
+   Retorna 0 ou -1 se faltar memória.
+*/
+int diarioCriar(Diario *diario, size_t capacidade) {
+    diario->registros = capacidade ? (RegistroDiario*) memAlocar(capacidade * sizeof(RegistroDiario)) : NULL;
+    diario->qtd = 0;
+    diario->capacidade = diario->registros ? capacidade : 0;
+    diario->proprio = 1;
+    diario->incompleto = 0;
+    return (capacidade && !diario->registros) ? -1 : 0;
+}
+
+/* diarioUsarBuffer():
+   Diário sobre um buffer do chamador (pilha, arena), sem alocação e sem
+   crescimento: o chamador garante que 'capacidade' basta.
+*/
+void diarioUsarBuffer(Diario *diario, RegistroDiario *buf, size_t capacidade) {
+    diario->registros = buf;
+    diario->qtd = 0;
+    diario->capacidade = capacidade;
+    diario->proprio = 0;
+    diario->incompleto = 0;
+}
+
+/* diarioLiberar():
+   Libera o buffer de um diário criado por diarioCriar().
+*/
+void diarioLiberar(Diario *diario) {
+    if (diario->proprio) free(diario->registros);
+    memset(diario, 0, sizeof(*diario));
+}
+
+/* diarioMarca():
+   Posição atual do diário, para desfazerAte() voltar até ela depois.
+*/
+size_t diarioMarca(const Diario *diario) {
+    return diario->qtd;
+}
+
+/* desfazerAte():
+   Desfaz as mutações anotadas depois de 'marca', da mais recente para a mais
+   antiga, via atualizarTerritorio() (os agregados voltam junto). O diário é
+   desligado durante a volta para que as restaurações não sejam anotadas.
+*/
+void desfazerAte(Mapa *mapa, size_t marca) {
+    Diario *diario = mapa->diario;
+    if (!diario) return;
+    mapa->diario = NULL;
+    while (diario->qtd > marca) {
+        const RegistroDiario *r = &diario->registros[--diario->qtd];
+        atualizarTerritorio(mapa, r->idx, r->dono, r->tropas);
+    }
+    mapa->diario = diario;
+}
+
+/* somarAgregados():
+   Agregados por cor em uma única passada sobre dono[]/tropas[]; territórios
+   sem dono (COR_NENHUMA) não entram em nenhuma cor.
+*/
+static void somarAgregados(const Mapa *mapa, long long territorios[MAX_CORES], long long tropas[MAX_CORES]) {
+    memset(territorios, 0, MAX_CORES * sizeof(long long));
+    memset(tropas, 0, MAX_CORES * sizeof(long long));
+    for (int i = 0; i < mapa->qtd; ++i) {
+        int dono = mapa->dono[i];
+        if (dono >= MAX_CORES) continue;
+        territorios[dono]++;
+        tropas[dono] += mapa->tropas[i];
+    }
+}
+
+/* recalcularAgregados():
+   Recalcula do zero os agregados por cor em uma passada pelo mapa
+   (usado quando o mapa é preenchido por fora de inicializarTerritorios).
+*/
+void recalcularAgregados(Mapa *mapa) {
+    somarAgregados(mapa, mapa->territoriosPorCor, mapa->tropasPorCor);
+}
+
+/* conferirAgregados():
+   Modo de depuração (compilar com -DWAR_DEBUG): compara os agregados
+   incrementais com os de uma passada completa e aborta se divergirem.
+*/
+void conferirAgregados(const Mapa *mapa) {
+    long long territorios[MAX_CORES], tropas[MAX_CORES];
+    somarAgregados(mapa, territorios, tropas);
+    for (int c = 0; c < MAX_CORES; ++c) {
+        if (territorios[c] != mapa->territoriosPorCor[c] || tropas[c] != mapa->tropasPorCor[c]) {
+            fprintf(stderr, "Agregados inconsistentes para a cor %d: territórios %lld/%lld, tropas %lld/%lld\n",
+                    c, mapa->territoriosPorCor[c], territorios[c], mapa->tropasPorCor[c], tropas[c]);
+            abort();
+        }
+    }
+}
+
+/* corEliminada():
+   Retorna 1 se a cor não domina mais nenhum território (consulta O(1)).
+*/
+int corEliminada(const Mapa *mapa, int cor) {
+    return mapa->territoriosPorCor[cor] == 0;
+}
+
+/* internarCor():
+   Retorna o id da cor no mapa, registrando-a na tabela se ainda não existir.
+   Retorna COR_NENHUMA se a tabela estiver cheia.
+*/
+int internarCor(Mapa *mapa, const char *cor) {
+    for (int c = 0; c < mapa->numCores; ++c)
+        if (strcmp(mapa->cores[c], cor) == 0) return c;
+    if (mapa->numCores >= MAX_CORES) return COR_NENHUMA;
+
+    strncpy(mapa->cores[mapa->numCores], cor, TAM_COR - 1);
+    mapa->cores[mapa->numCores][TAM_COR - 1] = '\0';
+    return mapa->numCores++;
+}
+
+/* nomeTerritorio():
+   Retorna o nome do território idx. Se o mapa não guarda nomes, gera
+   "Territorio_idx" em buf (de tamanho tam) e retorna buf.
+*/
+const char* nomeTerritorio(const Mapa *mapa, int idx, char *buf, size_t tam) {
+    if (mapa->nomes) return mapa->nomes[idx];
+    snprintf(buf, tam, "Territorio_%d", idx);
+    return buf;
+}
+
+/* liberarMemoria():
+   Libera a memória previamente alocada para o mapa e para a missão usando free.
+*/
+void liberarMemoria(Mapa *mapa, Missao *missao) {
+    if (mapa) {
+        free(mapa->dono);
+        free(mapa->tropas);
+        free(mapa->nomes);
+        free(mapa);
+        mapa = NULL;
+    }
+    if (missao) {
+        free(missao);
+        missao = NULL;
+    }
+}
+
+/* exibirMenuPrincipal():
+   Imprime na tela o menu de ações disponíveis para o jogador.
+*/
+void exibirMenuPrincipal(void) {
+    printf("\n--- MENU PRINCIPAL ---\n");
+    printf("1 - Fase de ataque\n");
+    printf("2 - Verificar missão (condição de vitória)\n");
+    printf("3 - Salvar jogo\n");
+    printf("4 - Modo de exibição do mapa\n");
+    printf("0 - Sair do jogo\n");
+}
+
+/* exibirMapa():
+   Mostra o estado atual de todos os territórios no mapa, formatado como tabela.
+   Usa 'const' para garantir que a função apenas leia os dados do mapa.
+   Quadro avulso: o laço do jogo usa um Renderizador persistente.
+*/
+void exibirMapa(const Mapa *mapa) {
+    Renderizador r;
+    if (criarRenderizador(&r, mapa, EXIBIR_COMPLETO) != 0) {
+        fprintf(stderr, "Falha ao alocar o buffer de exibição.\n");
+        return;
+    }
+    renderizarMapa(&r, mapa);
+    destruirRenderizador(&r);
+}
+
+/* criarRenderizador():
+   Pré-aloca o buffer de saída (proporcional ao mapa, limitado a
+   EXIBIR_BUFFER_MAX) e as cópias do quadro anterior. Retorna 0 ou -1.
+*/
+int criarRenderizador(Renderizador *r, const Mapa *mapa, int modo) {
+    memset(r, 0, sizeof(*r));
+    size_t porLinha = 64 + (mapa->grafo ? 8 * 12 : 0);
+    size_t capacidade = 4096 + (size_t) mapa->qtd * porLinha;
+    r->capacidade = capacidade < EXIBIR_BUFFER_MAX ? capacidade : EXIBIR_BUFFER_MAX;
+    r->buf = (char*) memAlocar(r->capacidade);
+    r->donoAnterior = (uint8_t*) memAlocar((size_t) mapa->qtd * sizeof(uint8_t));
+    r->tropasAnterior = (int*) memAlocar((size_t) mapa->qtd * sizeof(int));
+    if (!r->buf || !r->donoAnterior || !r->tropasAnterior) {
+        destruirRenderizador(r);
+        return -1;
+    }
+    r->modo = modo;
+    r->qtd = mapa->qtd;
+    return 0;
+}
+
+/* destruirRenderizador():
+   Libera o buffer e as cópias do quadro anterior.
+*/
+void destruirRenderizador(Renderizador *r) {
+    free(r->buf);
+    free(r->donoAnterior);
+    free(r->tropasAnterior);
+    memset(r, 0, sizeof(*r));
+}
+
+/* descarregarTela():
+   Envia o conteúdo do buffer ao stdout com write(), repetindo só em escrita
+   parcial. Esvazia antes o buffer do stdio para manter a ordem com printf().
+*/
+static void descarregarTela(Renderizador *r) {
+    fflush(stdout);
+    size_t enviado = 0;
+    while (enviado < r->usado) {
+        ssize_t n = write(STDOUT_FILENO, r->buf + enviado, r->usado - enviado);
+        if (n <= 0) break;
+        enviado += (size_t) n;
+    }
+    r->usado = 0;
+}
+
+/* reservarTela():
+   Garante 'tam' bytes livres no buffer: descarrega se estiver cheio e só
+   cresce se uma única linha não couber (território com muitos vizinhos).
+*/
+static int reservarTela(Renderizador *r, size_t tam) {
+    if (r->capacidade - r->usado >= tam) return 1;
+    descarregarTela(r);
+    if (r->capacidade >= tam) return 1;
+    char *novo = (char*) realloc(r->buf, tam);
+    if (!novo) return 0;
+    r->buf = novo;
+    r->capacidade = tam;
+    return 1;
+}
+
+/* Formatação manual (sem printf): texto, inteiro e alinhamento à esquerda.
+   O chamador já reservou espaço com reservarTela(). */
+static void telaTexto(Renderizador *r, const char *texto, int largura) {
+    size_t n = strlen(texto);
+    memcpy(r->buf + r->usado, texto, n);
+    r->usado += n;
+    for (int k = (int) n; k < largura; ++k) r->buf[r->usado++] = ' ';
+}
+
+static void telaInteiro(Renderizador *r, long long valor, int largura) {
+    char digitos[24];
+    int n = 0;
+    unsigned long long v = valor < 0 ? 0ULL - (unsigned long long) valor : (unsigned long long) valor;
+    do { digitos[n++] = (char) ('0' + v % 10); v /= 10; } while (v);
+    int total = n + (valor < 0);
+    if (valor < 0) r->buf[r->usado++] = '-';
+    while (n) r->buf[r->usado++] = digitos[--n];
+    for (int k = total; k < largura; ++k) r->buf[r->usado++] = ' ';
+}
+
+/* telaLinhaTerritorio():
+   Uma linha da tabela: IDX NOME COR TROPAS [VIZINHOS].
+*/
+static void telaLinhaTerritorio(Renderizador *r, const Mapa *mapa, int i) {
+    char nome[TAM_NOME];
+    const Grafo *g = mapa->grafo;
+    size_t grau = g ? (size_t) (g->inicio[i + 1] - g->inicio[i]) : 0;
+    if (!reservarTela(r, 64 + TAM_NOME + TAM_COR + grau * 12)) return;
+    telaInteiro(r, i, 4);
+    r->buf[r->usado++] = ' ';
+    telaTexto(r, nomeTerritorio(mapa, i, nome, sizeof(nome)), 15);
+    r->buf[r->usado++] = ' ';
+    telaTexto(r, mapa->cores[mapa->dono[i]], 10);
+    r->buf[r->usado++] = ' ';
+    telaInteiro(r, mapa->tropas[i], 7);
+    for (size_t e = 0; e < grau; ++e) {
+        r->buf[r->usado++] = e == 0 ? ' ' : ',';
+        telaInteiro(r, g->vizinhos[g->inicio[i] + (int64_t) e], 0);
+    }
+    r->buf[r->usado++] = '\n';
+}
+
+/* telaLinha():
+   Copia uma linha de texto fixo (cabeçalhos) para o buffer.
+*/
+static void telaLinha(Renderizador *r, const char *texto) {
+    if (!reservarTela(r, strlen(texto) + 1)) return;
+    telaTexto(r, texto, 0);
+}
+
+/* renderizarMapa():
+   Desenha um quadro do mapa no modo do renderizador:
+   - EXIBIR_COMPLETO: a tabela inteira; em mapas grandes, se o último quadro
+     completo foi há menos de EXIBIR_INTERVALO_MIN s, cai para o de alterações;
+   - EXIBIR_ALTERACOES: só os territórios cujo dono ou tropas mudaram desde o
+     último quadro (o primeiro quadro é completo);
+   - EXIBIR_RESUMO: totais por cor (dos agregados, O(cores)) e uma página de
+     EXIBIR_POR_PAGINA territórios.
+   O quadro é montado no buffer com formatação manual e sai em uma única
+   write() (ou poucas, se passar de EXIBIR_BUFFER_MAX).
+*/
+void renderizarMapa(Renderizador *r, const Mapa *mapa) {
+    INSTR_ESCOPO(FASE_SAIDA);
+    int modo = r->modo;
+    double agora = segundosMonotonicos();
+    if (!r->temAnterior || r->qtd != mapa->qtd) {
+        if (modo == EXIBIR_ALTERACOES) modo = EXIBIR_COMPLETO;
+    } else if (modo == EXIBIR_COMPLETO && mapa->qtd > EXIBIR_LIMITE_COMPLETO &&
+               agora - r->ultimoCompleto < EXIBIR_INTERVALO_MIN) {
+        modo = EXIBIR_ALTERACOES;
+    }
+    const char *cabecalho = mapa->grafo ? "IDX  NOME            COR        TROPAS  VIZINHOS\n"
+                                        : "IDX  NOME            COR        TROPAS  \n";
+
+    if (modo == EXIBIR_COMPLETO) {
+        telaLinha(r, "\n--- MAPA ATUAL ---\n");
+        telaLinha(r, cabecalho);
+        for (int i = 0; i < mapa->qtd; ++i) telaLinhaTerritorio(r, mapa, i);
+        r->ultimoCompleto = agora;
+    } else if (modo == EXIBIR_ALTERACOES) {
+        telaLinha(r, "\n--- MAPA: ALTERAÇÕES DESDE O ÚLTIMO QUADRO ---\n");
+        telaLinha(r, cabecalho);
+        long long alterados = 0;
+        for (int i = 0; i < mapa->qtd; ++i) {
+            if (mapa->dono[i] != r->donoAnterior[i] || mapa->tropas[i] != r->tropasAnterior[i]) {
+                telaLinhaTerritorio(r, mapa, i);
+                alterados++;
+            }
+        }
+        reservarTela(r, 64);
+        telaInteiro(r, alterados, 0);
+        telaTexto(r, " território(s) alterado(s).\n", 0);
+    } else {
+        int paginas = (mapa->qtd + EXIBIR_POR_PAGINA - 1) / EXIBIR_POR_PAGINA;
+        if (r->pagina < 0) r->pagina = 0;
+        if (r->pagina >= paginas) r->pagina = paginas - 1;
+        telaLinha(r, "\n--- MAPA: RESUMO ---\n");
+        for (int c = 0; c < mapa->numCores; ++c) {
+            reservarTela(r, 96);
+            telaTexto(r, mapa->cores[c], 10);
+            r->buf[r->usado++] = ' ';
+            telaInteiro(r, mapa->territoriosPorCor[c], 0);
+            telaTexto(r, " territórios, ", 0);
+            telaInteiro(r, mapa->tropasPorCor[c], 0);
+            telaTexto(r, " tropas\n", 0);
+        }
+        reservarTela(r, 96);
+        telaTexto(r, "Página ", 0);
+        telaInteiro(r, r->pagina + 1, 0);
+        r->buf[r->usado++] = '/';
+        telaInteiro(r, paginas, 0);
+        telaTexto(r, " (menu 4 troca a página ou o modo)\n", 0);
+        telaLinha(r, cabecalho);
+        int fim = (r->pagina + 1) * EXIBIR_POR_PAGINA;
+        for (int i = r->pagina * EXIBIR_POR_PAGINA; i < fim && i < mapa->qtd; ++i)
+            telaLinhaTerritorio(r, mapa, i);
+    }
+    descarregarTela(r);
+
+    /* guarda o quadro para o próximo diff (memcpy: bem mais barato que formatar) */
+    if (r->qtd == mapa->qtd) {
+        memcpy(r->donoAnterior, mapa->dono, (size_t) mapa->qtd * sizeof(uint8_t));
+        memcpy(r->tropasAnterior, mapa->tropas, (size_t) mapa->qtd * sizeof(int));
+        r->temAnterior = 1;
+    }
+}
+
+/* exibirMissao():
+   Exibe a descrição da missão atual do jogador com base na struct Missao.
+*/
+void exibirMissao(const Missao *missao) {
+    printf("\n--- SUA MISSÃO ---\n");
+    if (!missao) {
+        printf("Nenhuma missão atribuída.\n");
+        return;
+    }
+    printf("%s\n", missao->descricao);
+}
+
+/* exibirVerificacao():
+   Mensagem da opção "Verificar missão" (também usada pelo modo de comandos).
+*/
+void exibirVerificacao(int cumprida) {
+    if (cumprida) {
+        printf("\n🎉 MISSÃO CUMPRIDA! Parabéns, você venceu.\n");
+    } else {
+        printf("\nAinda não cumpriu a missão. Continue jogando.\n");
+    }
+}
+
+/* faseDeAtaque():
+   Gerencia a interface para a ação de ataque: solicita territórios de origem e destino,
+   valida entradas (propriedade do território e faixa) e chama executarAtaqueJogador()
+   para executar a batalha.
+*/
+void faseDeAtaque(Mapa *mapa, int corJogador, GeradorAleatorio *rng) {
+    INSTR_ESCOPO(FASE_ATAQUE);
+    int idxOrigem = -1, idxDestino = -1;
+
+    printf("\n--- FASE DE ATAQUE ---\n");
+    printf("Digite o índice do território de origem (ou -1 para cancelar): ");
+    if (scanf("%d", &idxOrigem) != 1) { limparBufferEntrada(); printf("Entrada inválida.\n"); return; }
+    limparBufferEntrada();
+    if (idxOrigem == -1) { printf("Ataque cancelado.\n"); return; }
+
+    printf("Digite o índice do território de destino: ");
+    if (scanf("%d", &idxDestino) != 1) { limparBufferEntrada(); printf("Entrada inválida.\n"); return; }
+    limparBufferEntrada();
+
+    executarAtaqueJogador(mapa, corJogador, idxOrigem, idxDestino, rng, 1);
+}
+
+/* executarAtaqueJogador():
+   Valida e executa o ataque do jogador, compartilhado pelo menu e pelo modo
+   de comandos. Com 'verboso' imprime as mensagens do jogo interativo
+   (motivo da recusa ou o relato de simularAtaque()); sem ele sorteia os
+   mesmos dados, na mesma ordem, e resolve em silêncio — o estado resultante
+   é idêntico. Retorna ATAQUE_OK ou o código do problema.
+*/
+int executarAtaqueJogador(Mapa *mapa, int corJogador, int idxOrigem, int idxDestino,
+                          GeradorAleatorio *rng, int verboso) {
+    int codigo = validarAtaque(mapa, idxOrigem, idxDestino, corJogador);
+    if (verboso) {
+        switch (codigo) {
+            case ATAQUE_FORA_DA_FAIXA:
+                printf("Índices fora da faixa válida.\n");
+                break;
+            case ATAQUE_MESMO_TERRITORIO:
+                printf("Origem e destino devem ser territórios diferentes.\n");
+                break;
+            case ATAQUE_ORIGEM_ALHEIA:
+                printf("Você só pode atacar a partir de territórios que pertençam à sua cor (%s).\n", mapa->cores[corJogador]);
+                break;
+            case ATAQUE_MESMA_COR:
+                printf("Não é permitido atacar território da mesma cor.\n");
+                break;
+            case ATAQUE_TROPAS_INSUFICIENTES:
+                printf("Tropas insuficientes para atacar (mínimo de 2 tropas requerido no território de origem).\n");
+                break;
+            case ATAQUE_NAO_VIZINHO:
+                printf("Só é possível atacar territórios que fazem fronteira com a origem.\n");
+                break;
+            default:
+                /* chama a simulação de ataque */
+                simularAtaque(mapa, idxOrigem, idxDestino, rng);
+                break;
+        }
+    } else if (codigo == ATAQUE_OK) {
+        int dadoAtk = rngDado(rng);
+        int dadoDef = rngDado(rng);
+        resolverBatalha(mapa, idxOrigem, idxDestino, dadoAtk, dadoDef, NULL);
+    }
+    return codigo;
+}
+
+/* validarAtaque():
+   Regras de validade de um ataque, compartilhadas por faseDeAtaque() e pelos
+   jogadores automáticos. Retorna ATAQUE_OK ou o código do primeiro problema.
+*/
+int validarAtaque(const Mapa *mapa, int idxOrigem, int idxDestino, int corJogador) {
+    INSTR_ESCOPO(FASE_VALIDAR);
+    /* validação de índices */
+    if (idxOrigem < 0 || idxOrigem >= mapa->qtd || idxDestino < 0 || idxDestino >= mapa->qtd)
+        return ATAQUE_FORA_DA_FAIXA;
+    if (idxOrigem == idxDestino)
+        return ATAQUE_MESMO_TERRITORIO;
+
+    /* validação: jogador só pode atacar a partir de território de sua própria cor */
+    if (mapa->dono[idxOrigem] != corJogador)
+        return ATAQUE_ORIGEM_ALHEIA;
+
+    /* validação: não atacar território da mesma cor */
+    if (mapa->dono[idxOrigem] == mapa->dono[idxDestino])
+        return ATAQUE_MESMA_COR;
+
+    /* validação: precisa ter pelo menos 2 tropas para realizar um ataque efetivo */
+    if (mapa->tropas[idxOrigem] < 2)
+        return ATAQUE_TROPAS_INSUFICIENTES;
+
+    /* validação: destino precisa fazer fronteira com a origem (O(grau)) */
+    if (!saoVizinhos(mapa, idxOrigem, idxDestino))
+        return ATAQUE_NAO_VIZINHO;
+
+    return ATAQUE_OK;
+}
+
+/* simularAtaque():
+   Executa a lógica de uma batalha entre dois territórios.
+   Regras:
+   - Rola um dado (1..6) para atacante e defensor.
+   - Se atacante > defensor:
+        - atacante vence: transfere cor para defensor e transfere metade (tropas do atacante / 2)
+          de tropas para o defensor (pelo menos 1). Atacante perde as tropas transferidas.
+   - Caso contrário:
+        - defensor vence: atacante perde 1 tropa.
+   A regra em si fica em resolverBatalha(); aqui apenas sorteamos os dados e exibimos o resultado.
+   A função modifica diretamente o mapa passado por ponteiro.
+*/
+void simularAtaque(Mapa *mapa, int idxAtacante, int idxDefensor, GeradorAleatorio *rng) {
+    INSTR_ESCOPO(FASE_SIMULAR);
+    char bufAtk[TAM_NOME], bufDef[TAM_NOME];
+    const char *nomeAtk = nomeTerritorio(mapa, idxAtacante, bufAtk, sizeof(bufAtk));
+    const char *nomeDef = nomeTerritorio(mapa, idxDefensor, bufDef, sizeof(bufDef));
+
+    printf("\nSimulando ataque: %s (%s, %d tropas) -> %s (%s, %d tropas)\n",
+           nomeAtk, mapa->cores[mapa->dono[idxAtacante]], mapa->tropas[idxAtacante],
+           nomeDef, mapa->cores[mapa->dono[idxDefensor]], mapa->tropas[idxDefensor]);
+
+    int dadoAtk = rngDado(rng);
+    int dadoDef = rngDado(rng);
+    printf("Dado atacante: %d | Dado defensor: %d\n", dadoAtk, dadoDef);
+
+    ResultadoBatalha res;
+    resolverBatalha(mapa, idxAtacante, idxDefensor, dadoAtk, dadoDef, &res);
+
+    if (res.conquistou) {
+        printf("Atacante venceu!\n");
+        printf("Território %s conquistado! Nova cor: %s, tropas: %d\n",
+               nomeDef, mapa->cores[mapa->dono[idxDefensor]], mapa->tropas[idxDefensor]);
+        printf("Tropas restantes no atacante %s: %d\n", nomeAtk, mapa->tropas[idxAtacante]);
+    } else {
+        printf("Defensor venceu!\n");
+        printf("Atacante perdeu 1 tropa. Tropas restantes: %d\n", mapa->tropas[idxAtacante]);
+    }
+}
+
+/* regraBatalha():
+   A regra de uma batalha, sem tocar no mapa: se o atacante vence, metade das
+   suas tropas (pelo menos 1) vai para o território conquistado; senão ele
+   perde 1 tropa. Devolve as tropas que restam no atacante (nunca negativas)
+   e em 'transferidas' as tropas movidas (0 se não houve conquista).
+*/
+static int regraBatalha(int tropasAtk, int dadoAtk, int dadoDef, int *transferidas) {
+    if (dadoAtk > dadoDef) {
+        *transferidas = tropasAtk / 2 < 1 ? 1 : tropasAtk / 2;
+        tropasAtk -= *transferidas;
+    } else {
+        *transferidas = 0;
+        tropasAtk -= 1;
+    }
+    return tropasAtk < 0 ? 0 : tropasAtk;
+}
+
+/* resolverBatalha():
+   Núcleo da batalha, compartilhado pelo jogo interativo e pelo modo em lote.
+   Aplica a regra de simularAtaque() para dados já sorteados, sem nenhuma E/S.
+   Preenche 'res' (se não for NULL) com os dados e o desfecho da batalha.
+*/
+void resolverBatalha(Mapa *mapa, int idxAtacante, int idxDefensor, int dadoAtk, int dadoDef, ResultadoBatalha *res) {
+    INSTR_ESCOPO(FASE_RESOLVER);
+    int conquistou = dadoAtk > dadoDef;
+    int tropasTransferidas;
+    int corAtk = mapa->dono[idxAtacante];
+    int corDef = mapa->dono[idxDefensor];
+    int tropasAtk = regraBatalha(mapa->tropas[idxAtacante], dadoAtk, dadoDef, &tropasTransferidas);
+
+    if (conquistou) {
+        /* atualiza defensor: ganha cor e recebe tropas transferidas */
+        atualizarTerritorio(mapa, idxDefensor, corAtk, tropasTransferidas);
+        INSTR_HISTOGRAMA(HIST_TRANSFERENCIAS, tropasTransferidas);
+    }
+    /* atualiza atacante: perde as tropas transferidas (ou 1, se perdeu) */
+    atualizarTerritorio(mapa, idxAtacante, corAtk, tropasAtk);
+
+    if (mapa->registrar) {
+        logEvento(LOG_BATALHA, corAtk, corDef, dadoAtk << 4 | dadoDef, idxAtacante, idxDefensor);
+        if (conquistou) logEvento(LOG_CONQUISTA, corAtk, corDef, 0, idxDefensor, tropasTransferidas);
+    }
+
+    if (res) {
+        res->dadoAtk = dadoAtk;
+        res->dadoDef = dadoDef;
+        res->conquistou = conquistou;
+        res->tropasTransferidas = tropasTransferidas;
+    }
+}
+
+/* criarLoteAtaques():
+   Aloca os vetores de um lote de até 'capacidade' ataques sobre um mapa de
+   qtdTerritorios territórios. Retorna 0 ou -1 se faltar memória.
+*/
+int criarLoteAtaques(LoteAtaques *lote, int capacidade, int qtdTerritorios) {
+    memset(lote, 0, sizeof(*lote));
+    lote->capacidade = capacidade;
+    lote->qtdTerritorios = qtdTerritorios;
+    lote->origens = (int*) memAlocar((size_t) capacidade * sizeof(int));
+    lote->destinos = (int*) memAlocar((size_t) capacidade * sizeof(int));
+    lote->resultados = (ResultadoBatalha*) memAlocar((size_t) capacidade * sizeof(ResultadoBatalha));
+    lote->codigos = (uint8_t*) memAlocar((size_t) capacidade);
+    lote->brutos = (uint64_t*) memAlocar(2 * (size_t) capacidade * sizeof(uint64_t));
+    lote->dados = (uint8_t*) memAlocar(2 * (size_t) capacidade);
+    lote->onda = (int*) memAlocar((size_t) capacidade * sizeof(int));
+    lote->ordem = (int*) memAlocar((size_t) capacidade * sizeof(int));
+    lote->inicioOnda = (int*) memAlocar(((size_t) capacidade + 2) * sizeof(int));
+    lote->ultimaOnda = (int*) memAlocarZerado((size_t) qtdTerritorios, sizeof(int));
+    if (!lote->origens || !lote->destinos || !lote->resultados || !lote->codigos || !lote->brutos ||
+        !lote->dados || !lote->onda || !lote->ordem || !lote->inicioOnda || !lote->ultimaOnda) {
+        destruirLoteAtaques(lote);
+        return -1;
+    }
+    return 0;
+}
+
+/* destruirLoteAtaques():
+   Libera os vetores do lote (seguro em lote parcialmente criado).
+*/
+void destruirLoteAtaques(LoteAtaques *lote) {
+    free(lote->origens);
+    free(lote->destinos);
+    free(lote->resultados);
+    free(lote->codigos);
+    free(lote->brutos);
+    free(lote->dados);
+    free(lote->onda);
+    free(lote->ordem);
+    free(lote->inicioOnda);
+    free(lote->ultimaOnda);
+    memset(lote, 0, sizeof(*lote));
+}
+
+/* converterDadosEscalar():
+   Converte saídas cruas do gerador em dados 1..6 exatamente como
+   rngIntervalo(rng, 6): parte alta * 6, com rejeição se a parte baixa do
+   produto for < 2^32 mod 6. Retorna a posição da primeira rejeição (ou n).
+*/
+static size_t converterDadosEscalar(const uint64_t *brutos, uint8_t *dados, size_t n) {
+    const uint32_t limite = (uint32_t) (-6u) % 6u;
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t m = (brutos[i] >> 32) * 6u;
+        if ((uint32_t) m < limite) return i;
+        dados[i] = (uint8_t) ((m >> 32) + 1);
+    }
+    return n;
+}
+
+#ifdef WAR_X86
+/* converterDadosAVX2():
+   Mesmo contrato de converterDadosEscalar(), 4 saídas por vez: a parte alta
+   de cada saída é multiplicada por 6 em 64 bits (vpmuludq), o dado é a parte
+   alta do produto e a rejeição é testada nas partes baixas de uma vez.
+*/
+__attribute__((target("avx2")))
+static size_t converterDadosAVX2(const uint64_t *brutos, uint8_t *dados, size_t n) {
+    const __m256i seis = _mm256_set1_epi64x(6);
+    const __m256i limite = _mm256_set1_epi64x((long long) ((uint32_t) (-6u) % 6u));
+    const __m256i baixo32 = _mm256_set1_epi64x(0xFFFFFFFFLL);
+    /* byte 0 de cada lane de 64 bits -> bytes 0 e 1 de cada metade */
+    const __m256i juntar = _mm256_setr_epi8(0, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                            0, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i v = _mm256_loadu_si256((const __m256i*) (brutos + i));
+        __m256i m = _mm256_mul_epu32(_mm256_srli_epi64(v, 32), seis);
+        __m256i rejeitado = _mm256_cmpgt_epi64(limite, _mm256_and_si256(m, baixo32));
+        if (!_mm256_testz_si256(rejeitado, rejeitado)) break;
+        __m256i d = _mm256_shuffle_epi8(_mm256_srli_epi64(m, 32), juntar);
+        uint32_t quatro = ((uint32_t) _mm_cvtsi128_si32(_mm256_castsi256_si128(d)) & 0xFFFFu) |
+                          ((uint32_t) _mm_cvtsi128_si32(_mm256_extracti128_si256(d, 1)) << 16);
+        quatro += 0x01010101u;
+        memcpy(dados + i, &quatro, sizeof(quatro));
+    }
+    return i + converterDadosEscalar(brutos + i, dados + i, n - i);
+}
+#endif
+
+/* Conversor de gerarDados(), escolhido uma vez (pthread_once) pela CPU */
+static size_t (*converterDados)(const uint64_t*, uint8_t*, size_t) = converterDadosEscalar;
+static pthread_once_t converterDadosOnce = PTHREAD_ONCE_INIT;
+
+static void escolherConverterDados(void) {
+#ifdef WAR_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) converterDados = converterDadosAVX2;
+#endif
+}
+
+/* gerarDados():
+   Rola n dados de uma vez, com o mesmo resultado (e o mesmo estado final do
+   gerador) de n chamadas a rngDado(): as saídas cruas saem em série do
+   xoshiro para 'brutos' e são convertidas em bloco (AVX2 se a CPU tiver).
+   Se alguma cair na rejeição de Lemire (chance de 4 em 2^32 por dado),
+   volta ao estado salvo e rola o resto dado a dado. Retorna n.
+*/
+size_t gerarDados(GeradorAleatorio *rng, uint8_t *dados, uint64_t *brutos, size_t n) {
+    pthread_once(&converterDadosOnce, escolherConverterDados);
+
+    GeradorAleatorio salvo = *rng;
+    for (size_t i = 0; i < n; ++i) brutos[i] = rngProximo(rng);
+    size_t feitos = converterDados(brutos, dados, n);
+    if (feitos < n) {
+        /* refaz a partir da rejeição: avança o estado salvo até ali e segue em série */
+        *rng = salvo;
+        for (size_t i = 0; i < feitos; ++i) rngProximo(rng);
+        for (size_t i = feitos; i < n; ++i) dados[i] = (uint8_t) rngDado(rng);
+    }
+    return n;
+}
+
+/* resolverAtaqueDoLote():
+   Resolve o ataque i do lote com os dados já sorteados, pelo caminho comum
+   (validarAtaque() + resolverBatalha()): o atacante é o dono atual da
+   origem. Retorna 1 se o ataque foi válido.
+*/
+static int resolverAtaqueDoLote(Mapa *mapa, LoteAtaques *lote, int i, int dadoAtk, int dadoDef) {
+    int origem = lote->origens[i], destino = lote->destinos[i];
+    int cor = (origem >= 0 && origem < mapa->qtd) ? mapa->dono[origem] : COR_NENHUMA;
+    int codigo = validarAtaque(mapa, origem, destino, cor);
+    lote->codigos[i] = (uint8_t) codigo;
+    if (codigo != ATAQUE_OK) {
+        lote->resultados[i] = (ResultadoBatalha) { dadoAtk, dadoDef, 0, 0 };
+        return 0;
+    }
+    resolverBatalha(mapa, origem, destino, dadoAtk, dadoDef, &lote->resultados[i]);
+    return 1;
+}
+
+/* resolverAtaquesEmSerie():
+   Referência de resolverLoteAtaques(): os mesmos ataques, um por vez e na
+   ordem do lote, cada um rolando seus dois dados com rngDado() — válido ou
+   não. Retorna o número de ataques válidos.
+*/
+int resolverAtaquesEmSerie(Mapa *mapa, LoteAtaques *lote, GeradorAleatorio *rng) {
+    int validos = 0;
+    for (int i = 0; i < lote->n; ++i) {
+        int dadoAtk = rngDado(rng);
+        int dadoDef = rngDado(rng);
+        validos += resolverAtaqueDoLote(mapa, lote, i, dadoAtk, dadoDef);
+    }
+    lote->numOndas = lote->n;
+    return validos;
+}
+
+/* agruparOndas():
+   Calcula a onda de cada ataque (1 + a maior onda que já tocou sua origem
+   ou seu destino) e agrupa os índices por onda em ordem[] com uma contagem
+   estável. Índices fora do mapa não tocam nada (o ataque será recusado).
+*/
+static void agruparOndas(LoteAtaques *lote) {
+    int numOndas = 0;
+    for (int i = 0; i < lote->n; ++i) {
+        int o = lote->origens[i], d = lote->destinos[i];
+        int valOrigem = (o >= 0 && o < lote->qtdTerritorios) ? 1 : 0;
+        int valDestino = (d >= 0 && d < lote->qtdTerritorios) ? 1 : 0;
+        int onda = 1;
+        if (valOrigem && lote->ultimaOnda[o] >= onda) onda = lote->ultimaOnda[o] + 1;
+        if (valDestino && lote->ultimaOnda[d] >= onda) onda = lote->ultimaOnda[d] + 1;
+        if (valOrigem) lote->ultimaOnda[o] = onda;
+        if (valDestino) lote->ultimaOnda[d] = onda;
+        lote->onda[i] = onda;
+        if (onda > numOndas) numOndas = onda;
+    }
+    /* devolve ultimaOnda[] zerado para o próximo lote (só o que foi tocado) */
+    for (int i = 0; i < lote->n; ++i) {
+        int o = lote->origens[i], d = lote->destinos[i];
+        if (o >= 0 && o < lote->qtdTerritorios) lote->ultimaOnda[o] = 0;
+        if (d >= 0 && d < lote->qtdTerritorios) lote->ultimaOnda[d] = 0;
+    }
+
+    memset(lote->inicioOnda, 0, ((size_t) numOndas + 2) * sizeof(int));
+    for (int i = 0; i < lote->n; ++i) lote->inicioOnda[lote->onda[i] + 1]++;
+    for (int w = 1; w <= numOndas + 1; ++w) lote->inicioOnda[w] += lote->inicioOnda[w - 1];
+    for (int i = 0; i < lote->n; ++i) lote->ordem[lote->inicioOnda[lote->onda[i]]++] = i;
+    /* o laço acima avançou cada início até o fim da sua onda: recua uma posição */
+    for (int w = numOndas + 1; w >= 1; --w) lote->inicioOnda[w] = lote->inicioOnda[w - 1];
+    lote->inicioOnda[0] = 0;
+    lote->numOndas = numOndas;
+}
+
+/* Largada dos trabalhadores de um lote: eles só começam depois que todas as
+   threads foram criadas, com numThreads e a barreira já ajustados a quantas
+   de fato subiram */
+typedef struct {
+    pthread_mutex_t trava;
+    pthread_cond_t sinal;
+    int liberado;
+    int numThreads;
+    pthread_barrier_t barreira;
+} LargadaLote;
+
+/* Trabalhador de resolverLoteAtaques(): uma fatia de cada onda, com os
+   deltas dos agregados acumulados localmente e somados ao mapa no fim */
+typedef struct {
+    Mapa *mapa;
+    LoteAtaques *lote;
+    LargadaLote *largada;
+    int indice;
+    int validos;
+    long long territorios[MAX_CORES];
+    long long tropas[MAX_CORES];
+} TrabalhadorLoteAtaques;
+
+/* resolverFatiaLote():
+   Resolve os ataques da fatia [de, ate) de ordem[] com aplicarMutacao()
+   sobre os deltas da fatia (sem diário: resolverLoteAtaques() não usa este
+   caminho com um ligado). Os ataques de uma onda não compartilham
+   territórios, então fatias da mesma onda nunca escrevem no mesmo lugar.
+   A regra é regraBatalha(), como em resolverBatalha().
+*/
+static void resolverFatiaLote(TrabalhadorLoteAtaques *t, int de, int ate) {
+    Mapa *mapa = t->mapa;
+    LoteAtaques *lote = t->lote;
+    for (int k = de; k < ate; ++k) {
+        int i = lote->ordem[k];
+        int origem = lote->origens[i], destino = lote->destinos[i];
+        int dadoAtk = lote->dados[2 * i], dadoDef = lote->dados[2 * i + 1];
+        int cor = (origem >= 0 && origem < mapa->qtd) ? mapa->dono[origem] : COR_NENHUMA;
+        int codigo = validarAtaque(mapa, origem, destino, cor);
+        ResultadoBatalha *res = &lote->resultados[i];
+        *res = (ResultadoBatalha) { dadoAtk, dadoDef, 0, 0 };
+        lote->codigos[i] = (uint8_t) codigo;
+        if (codigo != ATAQUE_OK) continue;
+        t->validos++;
+
+        int transferidas;
+        int restantes = regraBatalha(mapa->tropas[origem], dadoAtk, dadoDef, &transferidas);
+        int corDef = mapa->dono[destino];
+        if (transferidas) {
+            aplicarMutacao(mapa, t->territorios, t->tropas, destino, cor, transferidas);
+            res->conquistou = 1;
+            res->tropasTransferidas = transferidas;
+        }
+        aplicarMutacao(mapa, t->territorios, t->tropas, origem, cor, restantes);
+        if (mapa->registrar) {
+            logEvento(LOG_BATALHA, cor, corDef, dadoAtk << 4 | dadoDef, origem, destino);
+            if (transferidas) logEvento(LOG_CONQUISTA, cor, corDef, 0, destino, transferidas);
+        }
+    }
+}
+
+/* executarTrabalhadorLote():
+   Espera a largada; depois percorre as ondas em ordem, em cada uma resolve
+   sua fatia e espera as demais threads na barreira antes da onda seguinte.
+   Ondas pequenas ficam inteiras com a thread 0.
+*/
+static void* executarTrabalhadorLote(void *arg) {
+    TrabalhadorLoteAtaques *t = (TrabalhadorLoteAtaques*) arg;
+    LargadaLote *largada = t->largada;
+    pthread_mutex_lock(&largada->trava);
+    while (!largada->liberado) pthread_cond_wait(&largada->sinal, &largada->trava);
+    pthread_mutex_unlock(&largada->trava);
+
+    const LoteAtaques *lote = t->lote;
+    const int numThreads = largada->numThreads;
+    for (int w = 1; w <= lote->numOndas; ++w) {
+        int ini = lote->inicioOnda[w], fim = lote->inicioOnda[w + 1];
+        long long tam = fim - ini;
+        int partes = tam >= LOTE_MIN_PARALELO ? numThreads : 1;
+        if (t->indice < partes)
+            resolverFatiaLote(t, ini + (int) (tam * t->indice / partes), ini + (int) (tam * (t->indice + 1) / partes));
+        if (numThreads > 1) pthread_barrier_wait(&largada->barreira);
+    }
+    return NULL;
+}
+
+/* resolverLoteAtaques():
+   Resolve os lote->n ataques de uma vez. Os 2n dados saem de gerarDados();
+   o ataque i usa o par i, válido ou não. Os ataques são agrupados em ondas
+   (agruparOndas()) e cada onda é dividida entre até 'threads' threads, que
+   aplicam dono e tropas direto nos vetores do mapa; os agregados por cor
+   são somados uma vez no fim. O resultado — mapa, agregados, resultados[],
+   codigos[] e estado do gerador — é idêntico ao de resolverAtaquesEmSerie()
+   com a mesma semente. Com um diário ligado ao mapa, os ataques passam um a
+   um por resolverBatalha() (o diário precisa da ordem das mutações).
+   Se alguma thread não puder ser criada, o lote segue com as que subiram
+   (no limite, só a chamadora); o resultado é o mesmo.
+   Retorna o número de ataques válidos, ou -1 se faltar memória para as threads.
+*/
+int resolverLoteAtaques(Mapa *mapa, LoteAtaques *lote, GeradorAleatorio *rng, int threads) {
+    gerarDados(rng, lote->dados, lote->brutos, 2 * (size_t) lote->n);
+    agruparOndas(lote);
+
+    if (mapa->diario) {
+        int validos = 0;
+        for (int i = 0; i < lote->n; ++i)
+            validos += resolverAtaqueDoLote(mapa, lote, i, lote->dados[2 * i], lote->dados[2 * i + 1]);
+        return validos;
+    }
+
+    if (threads < 1) threads = 1;
+    TrabalhadorLoteAtaques *trab = (TrabalhadorLoteAtaques*) calloc((size_t) threads, sizeof(TrabalhadorLoteAtaques));
+    pthread_t *ids = (pthread_t*) calloc((size_t) threads, sizeof(pthread_t));
+    if (!trab || !ids) {
+        free(trab);
+        free(ids);
+        return -1;
+    }
+    LargadaLote largada;
+    pthread_mutex_init(&largada.trava, NULL);
+    pthread_cond_init(&largada.sinal, NULL);
+    largada.liberado = 0;
+    for (int k = 0; k < threads; ++k) {
+        trab[k].mapa = mapa;
+        trab[k].lote = lote;
+        trab[k].largada = &largada;
+        trab[k].indice = k;
+    }
+    int criadas = 1;
+    while (criadas < threads && pthread_create(&ids[criadas], NULL, executarTrabalhadorLote, &trab[criadas]) == 0)
+        criadas++;
+    threads = criadas;
+
+    /* só agora a quantidade de threads é conhecida: barreira e largada */
+    if (threads > 1) pthread_barrier_init(&largada.barreira, NULL, (unsigned) threads);
+    pthread_mutex_lock(&largada.trava);
+    largada.numThreads = threads;
+    largada.liberado = 1;
+    pthread_cond_broadcast(&largada.sinal);
+    pthread_mutex_unlock(&largada.trava);
+
+    executarTrabalhadorLote(&trab[0]);
+    for (int k = 1; k < threads; ++k)
+        pthread_join(ids[k], NULL);
+    if (threads > 1) pthread_barrier_destroy(&largada.barreira);
+    pthread_cond_destroy(&largada.sinal);
+    pthread_mutex_destroy(&largada.trava);
+
+    int validos = 0;
+    for (int k = 0; k < threads; ++k) {
+        validos += trab[k].validos;
+        for (int c = 0; c < MAX_CORES; ++c) {
+            mapa->territoriosPorCor[c] += trab[k].territorios[c];
+            mapa->tropasPorCor[c] += trab[k].tropas[c];
+        }
+    }
+    free(trab);
+    free(ids);
+    return validos;
+}
+
+/* executarBenchLote():
+   Modo não interativo: war --bench-lote [--territorios N] [--ataques N] [--lotes N]
+                        [--threads N] [--semente N] [--sem-fronteiras]
+   Joga --lotes lotes de --ataques ataques (origem sorteada, destino um
+   vizinho inimigo) em dois mapas iguais: um com resolverAtaquesEmSerie(),
+   outro com resolverLoteAtaques(). Confere que mapas, agregados, resultados
+   e geradores terminam idênticos e compara o tempo por ataque.
+   Retorna 0, ou 1 se houver divergência.
+*/
+int executarBenchLote(int argc, char *argv[]) {
+    int qtd = (int) lerOpcaoInteira(argc, argv, "--territorios", 1000000);
+    int numAtaques = (int) lerOpcaoInteira(argc, argv, "--ataques", 100000);
+    int numLotes = (int) lerOpcaoInteira(argc, argv, "--lotes", 20);
+    int threads = (int) lerOpcaoInteira(argc, argv, "--threads", sysconf(_SC_NPROCESSORS_ONLN));
+    uint64_t semente = (uint64_t) lerOpcaoInteira(argc, argv, "--semente", 1);
+    int semFronteiras = temOpcao(argc, argv, "--sem-fronteiras");
+    char cores[MAX_CORES][TAM_COR] = { "Azul", "Vermelho", "Verde", "Amarelo", "Preto", "Branco" };
+
+    if (qtd < 2 || numAtaques < 1 || numLotes < 1 || threads < 1) {
+        fprintf(stderr, "Uso: %s --bench-lote [--territorios N] [--ataques N] [--lotes N] [--threads N] [--semente N] [--sem-fronteiras]\n", argv[0]);
+        return 1;
+    }
+
+    Mapa *serie = alocarMapa(qtd, 0), *lote = alocarMapa(qtd, 0);
+    Grafo *grafo = semFronteiras ? NULL : gerarGrafoGrade(qtd);
+    LoteAtaques loteSerie, loteLote;
+    int okLoteSerie = criarLoteAtaques(&loteSerie, numAtaques, qtd) == 0;
+    int okLoteLote = criarLoteAtaques(&loteLote, numAtaques, qtd) == 0;
+    if (!serie || !lote || (!grafo && !semFronteiras) || !okLoteSerie || !okLoteLote) {
+        fprintf(stderr, "Falha na alocação de memória para o bench de lotes.\n");
+        if (okLoteSerie) destruirLoteAtaques(&loteSerie);
+        if (okLoteLote) destruirLoteAtaques(&loteLote);
+        liberarMemoria(serie, NULL);
+        liberarMemoria(lote, NULL);
+        liberarGrafo(grafo);
+        return 1;
+    }
+
+    GeradorAleatorio rngMapa, rngPares, rngSerie, rngLote;
+    rngSemear(&rngMapa, semente);
+    GeradorAleatorio copia = rngMapa;
+    inicializarTerritorios(serie, cores, 2, &rngMapa);
+    inicializarTerritorios(lote, cores, 2, &copia);
+    serie->grafo = lote->grafo = grafo;
+    lote->registrar = logAtivo();       /* só o mapa do lote: a série é a referência */
+    registrarInicioPartida(lote);
+    rngSemearFluxo(&rngPares, semente, 1);
+    rngSemearFluxo(&rngSerie, semente, 2);
+    rngLote = rngSerie;
+
+    double tempoSerie = 0.0, tempoLote = 0.0;
+    long long validos = 0, ondas = 0;
+    int divergiu = 0;
+    for (int l = 0; l < numLotes && !divergiu; ++l) {
+        /* pares sorteados sobre o estado atual (idêntico nos dois mapas) */
+        for (int i = 0; i < numAtaques; ++i) {
+            int o = (int) rngIntervalo(&rngPares, (uint32_t) qtd);
+            loteSerie.origens[i] = loteLote.origens[i] = o;
+            loteSerie.destinos[i] = loteLote.destinos[i] = escolherVizinhoInimigo(serie, o, serie->dono[o], &rngPares);
+        }
+        loteSerie.n = loteLote.n = numAtaques;
+
+        double inicio = segundosMonotonicos();
+        int vs = resolverAtaquesEmSerie(serie, &loteSerie, &rngSerie);
+        double meio = segundosMonotonicos();
+        int vl = resolverLoteAtaques(lote, &loteLote, &rngLote, threads);
+        tempoLote += segundosMonotonicos() - meio;
+        tempoSerie += meio - inicio;
+        if (vl < 0) {
+            fprintf(stderr, "Falha na alocação de memória para as threads do lote.\n");
+            divergiu = 1;
+            break;
+        }
+        validos += vs;
+        ondas += loteLote.numOndas;
+
+        divergiu = vs != vl ||
+            memcmp(serie->dono, lote->dono, (size_t) qtd) != 0 ||
+            memcmp(serie->tropas, lote->tropas, (size_t) qtd * sizeof(int)) != 0 ||
+            memcmp(serie->territoriosPorCor, lote->territoriosPorCor, sizeof(serie->territoriosPorCor)) != 0 ||
+            memcmp(serie->tropasPorCor, lote->tropasPorCor, sizeof(serie->tropasPorCor)) != 0 ||
+            memcmp(loteSerie.resultados, loteLote.resultados, (size_t) numAtaques * sizeof(ResultadoBatalha)) != 0 ||
+            memcmp(loteSerie.codigos, loteLote.codigos, (size_t) numAtaques) != 0 ||
+            memcmp(&rngSerie, &rngLote, sizeof(rngSerie)) != 0;
+        if (divergiu) fprintf(stderr, "Divergência entre série e lote no lote %d.\n", l + 1);
+    }
+
+    long long total = (long long) numAtaques * numLotes;
+    printf("=== BENCH LOTE (%d territórios, %d lotes de %d ataques, %d thread(s)) ===\n",
+           qtd, numLotes, numAtaques, threads);
+    printf("Ataques válidos: %lld de %lld | ondas por lote: %.1f\n", validos, total, (double) ondas / numLotes);
+    printf("%-8s %-12s %-12s\n", "MODO", "ns/ataque", "milhões/s");
+    printf("%-8s %-12.1f %-12.2f\n", "serie", tempoSerie * 1e9 / (double) total, (double) total / tempoSerie / 1e6);
+    printf("%-8s %-12.1f %-12.2f\n", "lote", tempoLote * 1e9 / (double) total, (double) total / tempoLote / 1e6);
+    printf("Resultado idêntico à série: %s\n", divergiu ? "NÃO" : "sim");
+
+    destruirLoteAtaques(&loteSerie);
+    destruirLoteAtaques(&loteLote);
+    liberarMemoria(serie, NULL);
+    liberarMemoria(lote, NULL);
+    liberarGrafo(grafo);
+    return divergiu ? 1 : 0;
+}
+
+/* sortearOutraCor():
+   Sorteia uma cor do mapa diferente da do jogador com um único sorteio entre
+   as numCores-1 restantes (sem repetir até acertar). Num mapa de uma cor só,
+   devolve a própria cor do jogador.
+*/
+static int sortearOutraCor(const Mapa *mapa, int corJogador, GeradorAleatorio *rng) {
+    int numCores = mapa->numCores;
+    if (corJogador < 0 || corJogador >= numCores)
+        return (int) rngIntervalo(rng, (uint32_t) numCores);
+    if (numCores < 2) return corJogador;
+    int escolha = (int) rngIntervalo(rng, (uint32_t) (numCores - 1));
+    return escolha + (escolha >= corJogador);
+}
+
+/* formatarDescricao():
+   Preenche o modelo de descrição da regra: {1}..{4} viram a quantidade do
+   termo correspondente e {cor} o nome da cor alvo. Os marcadores já foram
+   validados por compilarMissoes(); o texto é copiado sem snprintf(), que
+   custaria mais que o resto do sorteio.
+*/
+static void formatarDescricao(char *saida, size_t tam, const char *modelo, const long long *valores,
+                              const char *cor) {
+    size_t usado = 0;
+    for (const char *c = modelo; *c && usado + 1 < tam; ) {
+        if (*c != '{') {
+            saida[usado++] = *c++;
+            continue;
+        }
+        char num[24];
+        const char *texto = num;
+        if (c[1] == 'c') {
+            texto = cor;
+            c += 5;
+        } else {
+            long long v = valores[c[1] - '1'];
+            unsigned long long u = v < 0 ? 0ULL - (unsigned long long) v : (unsigned long long) v;
+            char *p = num + sizeof(num) - 1;
+            *p = '\0';
+            do { *--p = (char) ('0' + u % 10); u /= 10; } while (u);
+            if (v < 0) *--p = '-';
+            texto = p;
+            c += 3;
+        }
+        while (*texto && usado + 1 < tam) saida[usado++] = *texto++;
+    }
+    saida[usado] = '\0';
+}
+
+/* sortearMissao():
+   Sorteia e retorna (aloca dinamicamente, ou na arena se 'arena' não for NULL)
+   uma Missao para o jogador. A regra sai da tabela de missões ativa
+   (tabelaMissoes(); a padrão tem conquistar N territórios, destruir uma cor
+   e reunir X tropas) e é instanciada para este mapa: as quantidades são
+   calculadas (e sorteadas) na ordem dos termos, e a cor alvo "outra" é
+   sorteada uma vez entre as demais cores internadas. O resultado é o
+   programa de termos avaliado por verificarVitoria().
+*/
+Missao* sortearMissao(const Mapa *mapa, int corJogador, GeradorAleatorio *rng, Arena *arena) {
+    Missao *m = arena ? (Missao*) arenaAlocar(arena, sizeof(Missao)) : (Missao*) memAlocar(sizeof(Missao));
+    if (!m) return NULL;
+
+    const TabelaMissoes *tabela = tabelaMissoes();
+    int tipo = (int) rngIntervalo(rng, (uint32_t) tabela->numRegras);
+    const RegraMissao *regra = &tabela->regras[tipo];
+    m->tipo = tipo;
+    m->alvoCor = COR_NENHUMA;
+    m->numTermos = regra->numTermos;
+
+    long long valores[MISSAO_MAX_TERMOS];
+    for (int k = 0; k < regra->numTermos; ++k) {
+        const ModeloTermo *modelo = &regra->termos[k];
+        long long valor = 0;
+        for (int p = 0; p < modelo->numParcelas; ++p) {
+            const ParcelaMissao *parcela = &modelo->parcelas[p];
+            long long v = (long long) parcela->multiplicador * mapa->qtd / parcela->divisor + parcela->constante;
+            if (parcela->sorteio) {
+                if (v < 0) v = 0;
+                if (v > UINT32_MAX - 1) v = UINT32_MAX - 1;
+                v = (long long) rngIntervalo(rng, (uint32_t) (v + 1));
+            }
+            valor += v;
+        }
+
+        TermoMissao *t = &m->termos[k];
+        t->campo = modelo->campo;
+        t->sinal = modelo->sinal;
+        if (modelo->alvo == MISSAO_ALVO_OUTRA) {
+            if (m->alvoCor == COR_NENHUMA) m->alvoCor = sortearOutraCor(mapa, corJogador, rng);
+            t->cor = (uint8_t) m->alvoCor;
+        } else {
+            t->cor = MISSAO_COR_JOGADOR;
+        }
+        if (modelo->sinal > 0 && valor < 1) valor = 1; /* "ao menos 0" não é meta */
+        t->limiar = modelo->sinal > 0 ? valor : -valor;
+        valores[k] = valor;
+    }
+    m->alvoNumero = (int) valores[0];
+    formatarDescricao(m->descricao, sizeof(m->descricao), regra->descricao, valores,
+                      m->alvoCor != COR_NENHUMA ? mapa->cores[m->alvoCor] : "?");
+    return m;
+}
+
+/* montarMissaoPadrao():
+   Monta, sem sorteio, a missão de uma regra da tabela padrão (MISSao_*):
+   alvoNumero territórios ou tropas, ou eliminar alvoCor. A descrição fica vazia.
+*/
+void montarMissaoPadrao(Missao *missao, int tipo, int alvoNumero, int alvoCor) {
+    memset(missao, 0, sizeof(*missao));
+    missao->tipo = tipo;
+    missao->alvoNumero = alvoNumero;
+    missao->alvoCor = tipo == MISSao_DESTRUIR_COR ? alvoCor : COR_NENHUMA;
+    missao->numTermos = 1;
+    TermoMissao *t = &missao->termos[0];
+    if (tipo == MISSao_DESTRUIR_COR) {
+        t->campo = MISSAO_CAMPO_TERRITORIOS;
+        t->cor = (uint8_t) alvoCor;
+        t->sinal = -1;
+        t->limiar = 0;
+    } else {
+        t->campo = tipo == MISSao_REUNIR_TROPAS ? MISSAO_CAMPO_TROPAS : MISSAO_CAMPO_TERRITORIOS;
+        t->cor = MISSAO_COR_JOGADOR;
+        t->sinal = 1;
+        t->limiar = alvoNumero;
+    }
+}
+
+/* avaliarMissao():
+   Executa o programa da missão: cada termo é uma leitura de agregado, uma
+   multiplicação pelo sinal e uma comparação, sem desvios por tipo de regra.
+*/
+static inline int avaliarMissao(const Mapa *mapa, const Missao *missao, int corJogador) {
+    const long long *agregados[2] = { mapa->territoriosPorCor, mapa->tropasPorCor };
+    int cumprida = 1;
+    for (int k = 0; k < missao->numTermos; ++k) {
+        const TermoMissao *t = &missao->termos[k];
+        int cor = t->cor == MISSAO_COR_JOGADOR ? corJogador : t->cor;
+        cumprida &= t->sinal * agregados[t->campo][cor] >= t->limiar;
+    }
+    return cumprida;
+}
+
+/* verificarVitoria():
+   Verifica se o jogador cumpriu os requisitos de sua missão atual: todos os
+   termos do programa da missão (territórios ou tropas de uma cor contra um
+   limiar) precisam valer. Contagens e somas vêm dos agregados incrementais
+   do mapa, então cada verificação é O(termos), independente do tamanho do
+   mapa. Com -DWAR_DEBUG os agregados são conferidos contra uma varredura
+   completa (varrerMapa) a cada chamada.
+   Retorna 1 se cumprida, 0 caso contrário.
+*/
+int verificarVitoria(const Mapa *mapa, const Missao *missao, int corJogador) {
+    INSTR_ESCOPO(FASE_VITORIA);
+    if (!missao || !mapa) return 0;
+
+#ifdef WAR_DEBUG
+    conferirAgregados(mapa);
+#endif
+
+    return avaliarMissao(mapa, missao, corJogador);
+}
+
+/* verificarMissoes():
+   Verifica n missões de uma vez (a de índice k pertence à cor cores[k]) e
+   grava 1/0 em cumpridas[k]. Retorna quantas foram cumpridas.
+*/
+int verificarMissoes(const Mapa *mapa, const Missao *missoes, const uint8_t *cores, int n, uint8_t *cumpridas) {
+    INSTR_ESCOPO(FASE_VITORIA);
+#ifdef WAR_DEBUG
+    conferirAgregados(mapa);
+#endif
+    int total = 0;
+    for (int k = 0; k < n; ++k) {
+        cumpridas[k] = (uint8_t) avaliarMissao(mapa, &missoes[k], cores[k]);
+        total += cumpridas[k];
+    }
+    return total;
+}
+
+/* varrerCorEscalar():
+   Kernel de referência: em uma passada conta os territórios da cor 'cor',
+   soma as suas tropas e detecta se a cor 'alvo' ainda existe.
+*/
+void varrerCorEscalar(const uint8_t *dono, const int *tropas, size_t n, uint8_t cor, uint8_t alvo, VarreduraCor *out) {
+    long long cont = 0, soma = 0;
+    int presente = 0;
+    for (size_t i = 0; i < n; ++i) {
+        int meu = (dono[i] == cor);
+        cont += meu;
+        soma += meu ? tropas[i] : 0;
+        presente |= (dono[i] == alvo);
+    }
+    out->territorios = cont;
+    out->tropas = soma;
+    out->alvoPresente = presente;
+}
+
+#ifdef WAR_X86
+/* varrerCorSSE2():
+   Mesmo contrato de varrerCorEscalar(), processando 16 territórios por vez.
+   Contagem via movemask + popcount; as máscaras de byte são expandidas para
+   32 bits para filtrar as tropas, somadas em acumuladores de 64 bits.
+*/
+__attribute__((target("sse2")))
+void varrerCorSSE2(const uint8_t *dono, const int *tropas, size_t n, uint8_t cor, uint8_t alvo, VarreduraCor *out) {
+    const __m128i vCor = _mm_set1_epi8((char) cor);
+    const __m128i vAlvo = _mm_set1_epi8((char) alvo);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i soma64 = zero, presente = zero;
+    long long cont = 0;
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16) {
+        __m128i d = _mm_loadu_si128((const __m128i*) (dono + i));
+        __m128i eq = _mm_cmpeq_epi8(d, vCor);
+        presente = _mm_or_si128(presente, _mm_cmpeq_epi8(d, vAlvo));
+        cont += __builtin_popcount((unsigned) _mm_movemask_epi8(eq));
+
+        __m128i eq16lo = _mm_unpacklo_epi8(eq, eq), eq16hi = _mm_unpackhi_epi8(eq, eq);
+        __m128i m[4] = {
+            _mm_unpacklo_epi16(eq16lo, eq16lo), _mm_unpackhi_epi16(eq16lo, eq16lo),
+            _mm_unpacklo_epi16(eq16hi, eq16hi), _mm_unpackhi_epi16(eq16hi, eq16hi)
+        };
+        for (int k = 0; k < 4; ++k) {
+            /* tropas são não negativas: extensão com zero para 64 bits */
+            __m128i t = _mm_and_si128(_mm_loadu_si128((const __m128i*) (tropas + i + 4 * k)), m[k]);
+            soma64 = _mm_add_epi64(soma64, _mm_unpacklo_epi32(t, zero));
+            soma64 = _mm_add_epi64(soma64, _mm_unpackhi_epi32(t, zero));
+        }
+    }
+
+    long long parcial[2];
+    _mm_storeu_si128((__m128i*) parcial, soma64);
+    VarreduraCor resto;
+    varrerCorEscalar(dono + i, tropas + i, n - i, cor, alvo, &resto);
+    out->territorios = cont + resto.territorios;
+    out->tropas = parcial[0] + parcial[1] + resto.tropas;
+    out->alvoPresente = (_mm_movemask_epi8(presente) != 0) | resto.alvoPresente;
+}
+
+/* varrerCorAVX2():
+   Mesmo contrato de varrerCorEscalar(), processando 32 territórios por vez.
+*/
+__attribute__((target("avx2,popcnt")))
+void varrerCorAVX2(const uint8_t *dono, const int *tropas, size_t n, uint8_t cor, uint8_t alvo, VarreduraCor *out) {
+    const __m256i vCor = _mm256_set1_epi8((char) cor);
+    const __m256i vAlvo = _mm256_set1_epi8((char) alvo);
+    __m256i soma64 = _mm256_setzero_si256(), presente = _mm256_setzero_si256();
+    long long cont = 0;
+    size_t i = 0;
+
+    for (; i + 32 <= n; i += 32) {
+        __m256i d = _mm256_loadu_si256((const __m256i*) (dono + i));
+        __m256i eq = _mm256_cmpeq_epi8(d, vCor);
+        presente = _mm256_or_si256(presente, _mm256_cmpeq_epi8(d, vAlvo));
+        cont += __builtin_popcount((unsigned) _mm256_movemask_epi8(eq));
+
+        for (int k = 0; k < 4; ++k) {
+            /* máscara de 8 bytes -> 8 inteiros de 32 bits (0 ou -1) */
+            __m128i eqBytes = (k < 2) ? _mm256_castsi256_si128(eq) : _mm256_extracti128_si256(eq, 1);
+            if (k & 1) eqBytes = _mm_srli_si128(eqBytes, 8);
+            __m256i m = _mm256_cvtepi8_epi32(eqBytes);
+            __m256i t = _mm256_and_si256(_mm256_loadu_si256((const __m256i*) (tropas + i + 8 * k)), m);
+            soma64 = _mm256_add_epi64(soma64, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(t)));
+            soma64 = _mm256_add_epi64(soma64, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(t, 1)));
+        }
+    }
+
+    long long parcial[4];
+    _mm256_storeu_si256((__m256i*) parcial, soma64);
+    VarreduraCor resto;
+    varrerCorEscalar(dono + i, tropas + i, n - i, cor, alvo, &resto);
+    out->territorios = cont + resto.territorios;
+    out->tropas = parcial[0] + parcial[1] + parcial[2] + parcial[3] + resto.tropas;
+    out->alvoPresente = (_mm256_testz_si256(presente, presente) == 0) | resto.alvoPresente;
+}
+#else
+/* Sem x86: as versões vetoriais caem no kernel escalar */
+void varrerCorSSE2(const uint8_t *dono, const int *tropas, size_t n, uint8_t cor, uint8_t alvo, VarreduraCor *out) {
+    varrerCorEscalar(dono, tropas, n, cor, alvo, out);
+}
+void varrerCorAVX2(const uint8_t *dono, const int *tropas, size_t n, uint8_t cor, uint8_t alvo, VarreduraCor *out) {
+    varrerCorEscalar(dono, tropas, n, cor, alvo, out);
+}
+#endif
+
+/* escolherKernelVarredura():
+   Escolhe o melhor kernel suportado pela CPU em tempo de execução
+   (AVX2 > SSE2 > escalar). Se 'nome' não for NULL, recebe o nome do kernel.
+*/
+KernelVarredura escolherKernelVarredura(const char **nome) {
+#ifdef WAR_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        if (nome) *nome = "avx2";
+        return varrerCorAVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        if (nome) *nome = "sse2";
+        return varrerCorSSE2;
+    }
+#endif
+    if (nome) *nome = "escalar";
+    return varrerCorEscalar;
+}
+
+/* varrerMapa():
+   Varre o mapa com o kernel escolhido na primeira chamada (a escolha é
+   idempotente, então threads concorrentes podem fazê-la ao mesmo tempo).
+   'alvo' pode ser COR_NENHUMA quando não há cor alvo.
+*/
+void varrerMapa(const Mapa *mapa, int cor, int alvo, VarreduraCor *out) {
+    static _Atomic(KernelVarredura) escolhido = NULL;
+    KernelVarredura kernel = atomic_load_explicit(&escolhido, memory_order_relaxed);
+    if (!kernel) {
+        kernel = escolherKernelVarredura(NULL);
+        atomic_store_explicit(&escolhido, kernel, memory_order_relaxed);
+    }
+    kernel(mapa->dono, mapa->tropas, (size_t) mapa->qtd, (uint8_t) cor, (uint8_t) alvo, out);
+}
+
+/* executarBenchVitoria():
+   Benchmark: war --bench-vitoria [--max N]
+   Mede os kernels de varredura de verificarVitoria() em mapas de 1K, 1M e
+   100M territórios (limitados por --max) e imprime ns/território, GB/s e a
+   aceleração sobre o kernel escalar. Confere que todos dão o mesmo resultado.
+*/
+int executarBenchVitoria(int argc, char *argv[]) {
+    long long maximo = lerOpcaoInteira(argc, argv, "--max", 100000000LL);
+    const long long tamanhos[] = { 1000LL, 1000000LL, 100000000LL };
+    struct { const char *nome; KernelVarredura fn; int suportado; } kernels[3] = {
+        { "escalar", varrerCorEscalar, 1 },
+        { "sse2", varrerCorSSE2, 0 },
+        { "avx2", varrerCorAVX2, 0 },
+    };
+#ifdef WAR_X86
+    __builtin_cpu_init();
+    kernels[1].suportado = __builtin_cpu_supports("sse2");
+    kernels[2].suportado = __builtin_cpu_supports("avx2");
+#endif
+    const char *nomeEscolhido = NULL;
+    escolherKernelVarredura(&nomeEscolhido);
+
+    printf("=== BENCHMARK verificarVitoria (kernel em uso: %s) ===\n", nomeEscolhido);
+    printf("%-12s %-9s %-12s %-10s %-10s\n", "TERRITÓRIOS", "KERNEL", "ns/terr.", "GB/s", "ACELER.");
+
+    GeradorAleatorio rng;
+    rngSemear(&rng, 1);
+    for (int t = 0; t < 3; ++t) {
+        long long n = tamanhos[t];
+        if (n > maximo) break;
+
+        Mapa *mapa = alocarMapa((int) n, 0);
+        if (!mapa) {
+            fprintf(stderr, "Falha na alocação de %lld territórios.\n", n);
+            return 1;
+        }
+        for (long long i = 0; i < n; ++i) {
+            mapa->dono[i] = (uint8_t) rngIntervalo(&rng, 6);
+            mapa->tropas[i] = (int) rngIntervalo(&rng, 100) + 1;
+        }
+
+        /* repete cada kernel até somar ~2e8 territórios varridos (mínimo 3 vezes) */
+        long long repeticoes = 200000000LL / n;
+        if (repeticoes < 3) repeticoes = 3;
+
+        VarreduraCor ref;
+        varrerCorEscalar(mapa->dono, mapa->tropas, (size_t) n, 0, 5, &ref);
+        double tempoEscalar = 0.0;
+        for (int k = 0; k < 3; ++k) {
+            if (!kernels[k].suportado) continue;
+            VarreduraCor v;
+            volatile long long sumidouro = 0;
+            double inicio = segundosMonotonicos();
+            for (long long r = 0; r < repeticoes; ++r) {
+                kernels[k].fn(mapa->dono, mapa->tropas, (size_t) n, 0, 5, &v);
+                sumidouro += v.territorios;
+            }
+            double porVarredura = (segundosMonotonicos() - inicio) / (double) repeticoes;
+            if (k == 0) tempoEscalar = porVarredura;
+
+            if (v.territorios != ref.territorios || v.tropas != ref.tropas || v.alvoPresente != ref.alvoPresente) {
+                fprintf(stderr, "Kernel %s divergiu do escalar em %lld territórios.\n", kernels[k].nome, n);
+                liberarMemoria(mapa, NULL);
+                return 1;
+            }
+            printf("%-12lld %-9s %-12.3f %-10.2f %-10.2f\n", n, kernels[k].nome,
+                   porVarredura * 1e9 / (double) n,
+                   (double) n * (sizeof(uint8_t) + sizeof(int)) / porVarredura / 1e9,
+                   porVarredura > 0 ? tempoEscalar / porVarredura : 0.0);
+        }
+        liberarMemoria(mapa, NULL);
+    }
+    return 0;
+}
+
+/* simularSequenciaAtaque():
+   Motor em lote: simula 'amostras' sequências de ataque a partir de um par
+   (tropas do atacante, tropas do defensor). Em cada sequência o atacante repete
+   a batalha de resolverBatalha() enquanto tiver ao menos 2 tropas (mesma regra
+   de faseDeAtaque()) ou até conquistar o território. Nenhuma E/S no laço.
+   Os resultados são somados em 'est'.
+*/
+void simularSequenciaAtaque(int tropasAtk, int tropasDef, long long amostras, EstatisticaPar *est, GeradorAleatorio *rng) {
+    /* mapa de dois territórios (0 = atacante, 1 = defensor) em vetores na pilha;
+       os agregados do duelo nunca são consultados, então não são reiniciados */
+    uint8_t dono[2];
+    int tropas[2];
+    Mapa duelo;
+    memset(&duelo, 0, sizeof(duelo));
+    duelo.qtd = 2;
+    duelo.dono = dono;
+    duelo.tropas = tropas;
+
+    est->tropasAtk = tropasAtk;
+    est->tropasDef = tropasDef;
+
+    for (long long a = 0; a < amostras; ++a) {
+        dono[0] = 0;
+        dono[1] = 1;
+        tropas[0] = tropasAtk;
+        tropas[1] = tropasDef;
+
+        ResultadoBatalha res;
+        res.conquistou = 0;
+        res.tropasTransferidas = 0;
+        while (tropas[0] >= 2) {
+            int dadoAtk = rngDado(rng);
+            int dadoDef = rngDado(rng);
+            resolverBatalha(&duelo, 0, 1, dadoAtk, dadoDef, &res);
+            est->batalhas++;
+            if (res.conquistou) break;
+        }
+
+        est->amostras++;
+        /* tropas transferidas ao território conquistado não contam como perdas */
+        est->perdasAtk += tropasAtk - tropas[0] - res.tropasTransferidas * res.conquistou;
+        if (res.conquistou) {
+            est->conquistas++;
+            est->perdasDef += tropasDef;
+        }
+    }
+}
+
+/* simularSequenciaTabela():
+   Mesmo contrato de simularSequenciaAtaque(), mas cada sequência é amostrada
+   em O(1) na tabela de desfechos em vez de rolar batalha a batalha.
+*/
+void simularSequenciaTabela(int tropasAtk, int tropasDef, long long amostras, EstatisticaPar *est, GeradorAleatorio *rng) {
+    est->tropasAtk = tropasAtk;
+    est->tropasDef = tropasDef;
+
+    for (long long a = 0; a < amostras; ++a) {
+        DesfechoSequencia d;
+        amostrarSequencia(tropasAtk, tropasDef, rng, &d);
+        est->amostras++;
+        est->batalhas += d.batalhas;
+        /* tropas transferidas ao território conquistado não contam como perdas */
+        est->perdasAtk += tropasAtk - d.tropasAtk - (d.conquistou ? d.tropasDef : 0);
+        if (d.conquistou) {
+            est->conquistas++;
+            est->perdasDef += tropasDef;
+        }
+    }
+}
+
+/* ---------------------------------------------------------------------------
+   Tabela de desfechos das sequências de ataque.
+   Cada batalha é d6 contra d6: o atacante vence com p = 15/36 e perde 1 tropa
+   com q = 21/36. A sequência é uma cadeia de Markov em que só as tropas do
+   atacante importam: com k derrotas antes da primeira vitória (k < a-1) a
+   conquista ocorre com a-k tropas; com k = a-1 derrotas o atacante fica com 1
+   tropa e desiste. Logo P(k) = q^k p para k < a-1 e P(a-1) = q^(a-1). As
+   tropas do defensor só determinam o estado final dele quando não há conquista.
+   Para a <= TAB_BATALHA_MAX guardamos uma tabela de alias (amostragem O(1)
+   com dois sorteios); acima disso amostramos k pela inversa da geométrica.
+   --------------------------------------------------------------------------- */
+static pthread_once_t tabelaBatalhaOnce = PTHREAD_ONCE_INIT;
+static int tabelaInicio[TAB_BATALHA_MAX + 1];            /* deslocamento da linha 'a' */
+static uint32_t tabelaLimiar[TAB_BATALHA_ENTRADAS];      /* limiar de aceitação * 2^32 */
+static uint8_t tabelaAlias[TAB_BATALHA_ENTRADAS];        /* desfecho alternativo */
+static double tabelaPConquista[TAB_BATALHA_MAX + 1];     /* P(conquista) exata */
+static double tabelaPerdaAtk[TAB_BATALHA_MAX + 1];       /* E[tropas perdidas pelo atacante] */
+
+#define PROB_VITORIA_BATALHA (15.0 / 36.0)
+#define PROB_DERROTA_BATALHA (21.0 / 36.0)
+
+/* construirTabelaBatalha():
+   Preenche as linhas 2..TAB_BATALHA_MAX (executada uma única vez).
+*/
+static void construirTabelaBatalha(void) {
+    double prob[TAB_BATALHA_MAX], escala[TAB_BATALHA_MAX];
+    int pequenos[TAB_BATALHA_MAX], grandes[TAB_BATALHA_MAX];
+    int deslocamento = 0;
+
+    for (int a = 2; a <= TAB_BATALHA_MAX; ++a) {
+        tabelaInicio[a] = deslocamento;
+
+        /* distribuição do número de derrotas k = 0..a-1 */
+        double qk = 1.0, perda = 0.0;
+        for (int k = 0; k < a - 1; ++k) {
+            prob[k] = qk * PROB_VITORIA_BATALHA;
+            perda += prob[k] * k;
+            qk *= PROB_DERROTA_BATALHA;
+        }
+        prob[a - 1] = qk;
+        perda += qk * (a - 1);
+        tabelaPConquista[a] = 1.0 - qk;
+        tabelaPerdaAtk[a] = perda;
+
+        /* método de alias de Vose */
+        int np = 0, ng = 0;
+        for (int k = 0; k < a; ++k) {
+            escala[k] = prob[k] * a;
+            if (escala[k] < 1.0) pequenos[np++] = k; else grandes[ng++] = k;
+        }
+        while (np > 0 && ng > 0) {
+            int pq = pequenos[--np], gr = grandes[--ng];
+            tabelaLimiar[deslocamento + pq] = (uint32_t) (escala[pq] * 4294967296.0);
+            tabelaAlias[deslocamento + pq] = (uint8_t) gr;
+            escala[gr] -= 1.0 - escala[pq];
+            if (escala[gr] < 1.0) pequenos[np++] = gr; else grandes[ng++] = gr;
+        }
+        while (ng > 0) { int k = grandes[--ng]; tabelaLimiar[deslocamento + k] = UINT32_MAX; tabelaAlias[deslocamento + k] = (uint8_t) k; }
+        while (np > 0) { int k = pequenos[--np]; tabelaLimiar[deslocamento + k] = UINT32_MAX; tabelaAlias[deslocamento + k] = (uint8_t) k; }
+
+        deslocamento += a;
+    }
+}
+
+/* inicializarTabelaBatalha():
+   Garante que a tabela foi construída (preguiçosa e segura entre threads).
+*/
+void inicializarTabelaBatalha(void) {
+    pthread_once(&tabelaBatalhaOnce, construirTabelaBatalha);
+}
+
+/* probabilidadeConquista():
+   Probabilidade exata de uma sequência de ataque terminar em conquista.
+*/
+double probabilidadeConquista(int tropasAtk, int tropasDef) {
+    (void) tropasDef; /* não influencia a regra de batalha */
+    if (tropasAtk < 2) return 0.0;
+    if (tropasAtk <= TAB_BATALHA_MAX) {
+        inicializarTabelaBatalha();
+        return tabelaPConquista[tropasAtk];
+    }
+    return 1.0 - pow(PROB_DERROTA_BATALHA, tropasAtk - 1);
+}
+
+/* perdaEsperadaAtacante():
+   Número esperado de tropas que o atacante perde (em derrotas) na sequência.
+*/
+double perdaEsperadaAtacante(int tropasAtk, int tropasDef) {
+    (void) tropasDef;
+    if (tropasAtk < 2) return 0.0;
+    if (tropasAtk <= TAB_BATALHA_MAX) {
+        inicializarTabelaBatalha();
+        return tabelaPerdaAtk[tropasAtk];
+    }
+    /* E[min(K, a-1)] para K geométrica: soma_{k=1}^{a-1} q^k */
+    double q = PROB_DERROTA_BATALHA;
+    return q * (1.0 - pow(q, tropasAtk - 1)) / (1.0 - q);
+}
+
+/* desfechoPorPerdas():
+   Converte o número de derrotas da sequência no estado final dos territórios.
+*/
+void desfechoPorPerdas(int tropasAtk, int tropasDef, int perdas, DesfechoSequencia *out) {
+    if (tropasAtk < 2) {
+        out->conquistou = 0;
+        out->tropasAtk = tropasAtk;
+        out->tropasDef = tropasDef;
+        out->batalhas = 0;
+        return;
+    }
+    if (perdas >= tropasAtk - 1) {
+        out->conquistou = 0;
+        out->tropasAtk = 1;
+        out->tropasDef = tropasDef;
+        out->batalhas = tropasAtk - 1;
+    } else {
+        int t = tropasAtk - perdas; /* tropas no momento da vitória (t >= 2) */
+        out->conquistou = 1;
+        out->tropasDef = t / 2;
+        out->tropasAtk = t - t / 2;
+        out->batalhas = perdas + 1;
+    }
+}
+
+/* amostrarSequencia():
+   Sorteia o desfecho de uma sequência de ataque em O(1): tabela de alias
+   para até TAB_BATALHA_MAX tropas e inversa da geométrica acima disso.
+*/
+void amostrarSequencia(int tropasAtk, int tropasDef, GeradorAleatorio *rng, DesfechoSequencia *out) {
+    int perdas;
+    if (tropasAtk < 2) {
+        perdas = 0;
+    } else if (tropasAtk <= TAB_BATALHA_MAX) {
+        inicializarTabelaBatalha();
+        int base = tabelaInicio[tropasAtk];
+        int k = (int) rngIntervalo(rng, (uint32_t) tropasAtk);
+        uint32_t u = (uint32_t) rngProximo(rng);
+        perdas = (u < tabelaLimiar[base + k]) ? k : tabelaAlias[base + k];
+    } else {
+        /* K ~ Geométrica(p) (derrotas antes da primeira vitória) */
+        double u = ((double) (rngProximo(rng) >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+        double k = floor(log(u) / log(PROB_DERROTA_BATALHA));
+        perdas = (k >= (double) (tropasAtk - 1)) ? tropasAtk - 1 : (int) k;
+    }
+    desfechoPorPerdas(tropasAtk, tropasDef, perdas, out);
+}
+
+/* Trabalho de uma thread do modo em lote: um intervalo de pares (atk, def) */
+typedef struct {
+    EstatisticaPar *pares;  /* vetor compartilhado de resultados */
+    int inicio, fim;        /* intervalo [inicio, fim) de pares desta thread */
+    long long amostras;
+    uint64_t semente;
+    int usarTabela;         /* 1 = amostra o desfecho na tabela, 0 = rola batalha a batalha */
+    int emThread;           /* 1 = rodou em thread própria (precisa de join) */
+} TrabalhoLote;
+
+/* executarTrabalhoLote():
+   Corpo de cada thread do modo em lote. Cada par usa o seu próprio fluxo do
+   gerador (derivado da semente e do índice do par), de modo que o resultado
+   é idêntico bit a bit para qualquer número de threads.
+*/
+static void* executarTrabalhoLote(void *arg) {
+    TrabalhoLote *t = (TrabalhoLote*) arg;
+    for (int p = t->inicio; p < t->fim; ++p) {
+        GeradorAleatorio rng;
+        rngSemearFluxo(&rng, t->semente, (uint64_t) p);
+        EstatisticaPar *est = &t->pares[p];
+        if (t->usarTabela)
+            simularSequenciaTabela(est->tropasAtk, est->tropasDef, t->amostras, est, &rng);
+        else
+            simularSequenciaAtaque(est->tropasAtk, est->tropasDef, t->amostras, est, &rng);
+    }
+    return NULL;
+}
+
+/* executarModoLote():
+   Modo não interativo: war --simular [--atk N] [--def N] [--amostras N] [--threads N] [--semente N] [--tabela]
+   Roda simularSequenciaAtaque() (ou, com --tabela, simularSequenciaTabela())
+   para cada par 2..atk x 1..def, distribuindo os pares entre as threads, e
+   imprime probabilidade de conquista (estimada e exata), perdas esperadas e a
+   vazão de batalhas por segundo.
+*/
+int executarModoLote(int argc, char *argv[]) {
+    int maxAtk = (int) lerOpcaoInteira(argc, argv, "--atk", 10);
+    int maxDef = (int) lerOpcaoInteira(argc, argv, "--def", 6);
+    long long amostras = lerOpcaoInteira(argc, argv, "--amostras", 100000);
+    int numThreads = (int) lerOpcaoInteira(argc, argv, "--threads", 1);
+    uint64_t semente = (uint64_t) lerOpcaoInteira(argc, argv, "--semente", 1);
+    int usarTabela = temOpcao(argc, argv, "--tabela");
+
+    if (maxAtk < 2 || maxDef < 1 || amostras < 1 || numThreads < 1) {
+        fprintf(stderr, "Uso: %s --simular [--atk N>=2] [--def N>=1] [--amostras N>=1] [--threads N>=1] [--semente N] [--tabela]\n", argv[0]);
+        return 1;
+    }
+
+    int numPares = (maxAtk - 1) * maxDef;
+    if (numThreads > numPares) numThreads = numPares;
+    EstatisticaPar *pares = (EstatisticaPar*) calloc((size_t) numPares, sizeof(EstatisticaPar));
+    TrabalhoLote *trabalhos = (TrabalhoLote*) calloc((size_t) numThreads, sizeof(TrabalhoLote));
+    pthread_t *threads = (pthread_t*) calloc((size_t) numThreads, sizeof(pthread_t));
+    if (!pares || !trabalhos || !threads) {
+        fprintf(stderr, "Falha na alocação de memória para o modo em lote.\n");
+        free(pares); free(trabalhos); free(threads);
+        return 1;
+    }
+    for (int a = 2, p = 0; a <= maxAtk; ++a) {
+        for (int d = 1; d <= maxDef; ++d, ++p) {
+            pares[p].tropasAtk = a;
+            pares[p].tropasDef = d;
+        }
+    }
+
+    double inicio = segundosMonotonicos();
+    for (int t = 0; t < numThreads; ++t) {
+        trabalhos[t].pares = pares;
+        trabalhos[t].inicio = (int) ((long long) numPares * t / numThreads);
+        trabalhos[t].fim = (int) ((long long) numPares * (t + 1) / numThreads);
+        trabalhos[t].amostras = amostras;
+        trabalhos[t].semente = semente;
+        trabalhos[t].usarTabela = usarTabela;
+        trabalhos[t].emThread = pthread_create(&threads[t], NULL, executarTrabalhoLote, &trabalhos[t]) == 0;
+    }
+    /* fatias cujas threads não subiram rodam aqui (o resultado não depende da thread) */
+    int semThread = 0;
+    for (int t = 0; t < numThreads; ++t) {
+        if (trabalhos[t].emThread) continue;
+        executarTrabalhoLote(&trabalhos[t]);
+        semThread++;
+    }
+    for (int t = 0; t < numThreads; ++t)
+        if (trabalhos[t].emThread) pthread_join(threads[t], NULL);
+    if (semThread)
+        fprintf(stderr, "Aviso: %d thread(s) não puderam ser criadas; as fatias rodaram na thread principal.\n", semThread);
+    double decorrido = segundosMonotonicos() - inicio;
+
+    printf("=== SIMULAÇÃO EM LOTE (%lld amostras por par, %d threads, semente %llu, %s) ===\n",
+           amostras, numThreads, (unsigned long long) semente, usarTabela ? "tabela" : "dados");
+    printf("%-6s %-6s %-12s %-12s %-12s %-12s\n", "ATK", "DEF", "P(CONQ)", "P(EXATA)", "PERDA_ATK", "PERDA_DEF");
+    long long totalBatalhas = 0;
+    for (int p = 0; p < numPares; ++p) {
+        const EstatisticaPar *est = &pares[p];
+        totalBatalhas += est->batalhas;
+        printf("%-6d %-6d %-12.4f %-12.4f %-12.4f %-12.4f\n", est->tropasAtk, est->tropasDef,
+               (double) est->conquistas / (double) est->amostras,
+               probabilidadeConquista(est->tropasAtk, est->tropasDef),
+               (double) est->perdasAtk / (double) est->amostras,
+               (double) est->perdasDef / (double) est->amostras);
+    }
+
+    long long totalAmostras = (long long) numPares * amostras;
+    printf("\nBatalhas equivalentes: %lld em %.3f s (%.2f milhões/s) | sequências: %.2f milhões/s\n",
+           totalBatalhas, decorrido,
+           decorrido > 0 ? (double) totalBatalhas / decorrido / 1e6 : 0.0,
+           decorrido > 0 ? (double) totalAmostras / decorrido / 1e6 : 0.0);
+
+    free(pares);
+    free(trabalhos);
+    free(threads);
+    return 0;
+}
+
+/* escolherAtaqueAleatorio():
+   Jogador automático simples: sorteia uma origem da cor do jogador com ao
+   menos 2 tropas e que tenha um vizinho inimigo, e ataca esse vizinho.
+   Tenta alguns sorteios diretos e, se falharem, varre o mapa a partir de uma
+   posição aleatória, cobrindo o mapa inteiro: só falha se não houver ataque.
+   Retorna 1 e preenche os índices se houver ataque válido, 0 caso contrário.
+*/
+int escolherAtaqueAleatorio(const Mapa *mapa, int corJogador, GeradorAleatorio *rng, int *idxOrigem, int *idxDestino) {
+    int qtd = mapa->qtd;
+    int partida = (int) rngIntervalo(rng, (uint32_t) qtd);
+
+    for (int k = 0; k < qtd + 8; ++k) {
+        int i = (k < 8) ? (int) rngIntervalo(rng, (uint32_t) qtd) : (partida + k - 8) % qtd;
+        if (mapa->tropas[i] < 2 || mapa->dono[i] != corJogador) continue;
+
+        int destino = escolherVizinhoInimigo(mapa, i, corJogador, rng);
+        if (destino >= 0) {
+            *idxOrigem = i;
+            *idxDestino = destino;
+            return validarAtaque(mapa, i, destino, corJogador) == ATAQUE_OK;
+        }
+    }
+    return 0;
+}
+
+/* jogarPartidaAutomatica():
+   Joga uma partida completa sem E/S: inicializa o mapa (já alocado pelo
+   chamador), sorteia a missão de "Azul" e executa ataques automáticos até
+   verificarVitoria() ter sucesso, não haver ataque possível ou atingir
+   MAX_ATAQUES_PARTIDA. Soma os resultados em 'est'. Se 'arena' não for NULL,
+   a missão sai dela e não é liberada aqui.
+*/
+void jogarPartidaAutomatica(Mapa *mapa, char cores[][TAM_COR], int numCores, GeradorAleatorio *rng,
+                            Arena *arena, EstatisticaPartidas *est) {
+    INSTR_ESCOPO(FASE_PARTIDA);
+    inicializarTerritorios(mapa, cores, numCores, rng);
+    const int corJogador = internarCor(mapa, cores[0]);
+    Missao *missao = sortearMissao(mapa, corJogador, rng, arena);
+    if (!missao) return;
+    registrarInicioPartida(mapa);
+    registrarMissao(mapa, corJogador, missao);
+
+    int venceu = verificarVitoria(mapa, missao, corJogador);
+    int batalhas = 0, conquistas = 0;
+    for (int a = 0; !venceu && a < MAX_ATAQUES_PARTIDA; ++a) {
+        int idxOrigem, idxDestino;
+        if (!escolherAtaqueAleatorio(mapa, corJogador, rng, &idxOrigem, &idxDestino)) break;
+
+        ResultadoBatalha res;
+        int dadoAtk = rngDado(rng);
+        int dadoDef = rngDado(rng);
+        resolverBatalha(mapa, idxOrigem, idxDestino, dadoAtk, dadoDef, &res);
+        batalhas++;
+        conquistas += res.conquistou;
+
+        venceu = verificarVitoria(mapa, missao, corJogador);
+    }
+
+    INSTR_HISTOGRAMA(HIST_BATALHAS, batalhas);
+    INSTR_HISTOGRAMA(HIST_CONQUISTAS, conquistas);
+    est->ataques += batalhas;
+    est->conquistas += conquistas;
+    est->partidas++;
+    if (venceu) {
+        est->vitorias++;
+        est->porTipo[missao->tipo]++;
+        registrarVitoria(mapa, corJogador, missao);
+    }
+    if (!arena) liberarMemoria(NULL, missao);
+}
+
+/* Estado compartilhado de uma execução do executor paralelo */
+typedef struct {
+    FilaPartidas *filas;    /* uma fila por trabalhador */
+    int numTrabalhadores;
+    int qtdTerritorios;
+    int numCores;
+    uint64_t semente;
+    char (*cores)[TAM_COR];
+    const Grafo *grafo;     /* fronteiras compartilhadas (somente leitura) */
+    int registrar;          /* 1 = partidas vão para o log de eventos */
+} ExecucaoPartidas;
+
+/* Contexto de um trabalhador: mapa próprio e estatísticas locais */
+typedef struct {
+    ExecucaoPartidas *exec;
+    int id;
+    EstatisticaPartidas est;
+    long long roubos;       /* quantas vezes roubou trabalho de outra fila */
+    int emThread;           /* 1 = rodou em thread própria (precisa de join) */
+    int falhou;             /* 1 = parou por falta de memória para a arena */
+} TrabalhadorPartidas;
+
+/* pegarPartida():
+   Retira a próxima partida do início da própria fila. Retorna -1 se vazia.
+*/
+static long long pegarPartida(FilaPartidas *fila) {
+    uint64_t atual = atomic_load(&fila->intervalo);
+    for (;;) {
+        uint32_t inicio = (uint32_t) (atual >> 32), fim = (uint32_t) atual;
+        if (inicio >= fim) return -1;
+        uint64_t novo = ((uint64_t) (inicio + 1) << 32) | fim;
+        if (atomic_compare_exchange_weak(&fila->intervalo, &atual, novo)) return inicio;
+    }
+}
+
+/* roubarPartidas():
+   Rouba a metade final da fila 'vitima' e a instala na fila 'destino'
+   (que deve estar vazia). Retorna 1 se conseguiu roubar algo.
+*/
+static int roubarPartidas(FilaPartidas *vitima, FilaPartidas *destino) {
+    uint64_t atual = atomic_load(&vitima->intervalo);
+    for (;;) {
+        uint32_t inicio = (uint32_t) (atual >> 32), fim = (uint32_t) atual;
+        if (inicio >= fim) return 0;
+        uint32_t meio = fim - (fim - inicio + 1) / 2;
+        uint64_t novo = ((uint64_t) inicio << 32) | meio;
+        if (atomic_compare_exchange_weak(&vitima->intervalo, &atual, novo)) {
+            atomic_store(&destino->intervalo, ((uint64_t) meio << 32) | fim);
+            return 1;
+        }
+    }
+}
+
+/* executarTrabalhador():
+   Laço de cada thread: joga partidas da própria fila e, quando ela esvazia,
+   rouba trabalho das demais. Cada trabalhador reserva uma arena uma única vez;
+   mapa e missão de cada partida saem dela e são reciclados com
+   arenaReiniciar(). O gerador de cada partida deriva do seu índice global,
+   então os resultados não dependem do escalonamento. Sem memória para a
+   arena, marca 'falhou' e deixa a fila para os demais roubarem.
+*/
+static void* executarTrabalhador(void *arg) {
+    TrabalhadorPartidas *tr = (TrabalhadorPartidas*) arg;
+    ExecucaoPartidas *exec = tr->exec;
+    FilaPartidas *minha = &exec->filas[tr->id];
+
+    Arena arena;
+    if (arenaCriar(&arena, tamanhoArenaPartida(exec->qtdTerritorios, 0)) != 0) {
+        tr->falhou = 1;
+        return NULL;
+    }
+
+    for (;;) {
+        long long idx = pegarPartida(minha);
+        if (idx < 0) {
+            int roubou = 0;
+            for (int k = 1; k < exec->numTrabalhadores && !roubou; ++k) {
+                int vitima = (tr->id + k) % exec->numTrabalhadores;
+                roubou = roubarPartidas(&exec->filas[vitima], minha);
+            }
+            if (!roubou) break;
+            tr->roubos++;
+            continue;
+        }
+
+        arenaReiniciar(&arena);
+        Mapa *mapa = alocarMapaArena(&arena, exec->qtdTerritorios, 0);
+        if (!mapa) {
+            tr->falhou = 1;
+            break;
+        }
+        mapa->grafo = exec->grafo;
+        mapa->registrar = exec->registrar;
+        logPartida((uint32_t) idx);
+
+        GeradorAleatorio rng;
+        rngSemearFluxo(&rng, exec->semente, (uint64_t) idx);
+        jogarPartidaAutomatica(mapa, exec->cores, exec->numCores, &rng, &arena, &tr->est);
+    }
+
+    arenaDestruir(&arena);
+    return NULL;
+}
+
+/* executarPartidasParalelas():
+   Distribui 'numPartidas' partidas entre 'numThreads' trabalhadores, espera o
+   fim e mescla as estatísticas locais em 'total'. Com 'registrar', as
+   partidas vão para o log de eventos (cada uma com o seu índice como id).
+   Retorna o tempo em segundos, ou -1 em caso de falha de alocação (inclusive
+   se trabalhadores sem arena deixaram partidas sem jogar).
+*/
+static double executarPartidasParalelas(long long numPartidas, int numThreads, int qtdTerritorios, int numCores,
+                                        char cores[][TAM_COR], uint64_t semente, const Grafo *grafo,
+                                        int registrar, EstatisticaPartidas *total, long long *roubos) {
+    FilaPartidas *filas = (FilaPartidas*) calloc((size_t) numThreads, sizeof(FilaPartidas));
+    TrabalhadorPartidas *trab = (TrabalhadorPartidas*) calloc((size_t) numThreads, sizeof(TrabalhadorPartidas));
+    pthread_t *threads = (pthread_t*) calloc((size_t) numThreads, sizeof(pthread_t));
+    if (!filas || !trab || !threads) {
+        free(filas); free(trab); free(threads);
+        return -1.0;
+    }
+
+    ExecucaoPartidas exec = { filas, numThreads, qtdTerritorios, numCores, semente, cores, grafo, registrar };
+    for (int t = 0; t < numThreads; ++t) {
+        uint32_t inicio = (uint32_t) (numPartidas * t / numThreads);
+        uint32_t fim = (uint32_t) (numPartidas * (t + 1) / numThreads);
+        atomic_init(&filas[t].intervalo, ((uint64_t) inicio << 32) | fim);
+        trab[t].exec = &exec;
+        trab[t].id = t;
+    }
+
+    double inicio = segundosMonotonicos();
+    for (int t = 0; t < numThreads; ++t)
+        trab[t].emThread = pthread_create(&threads[t], NULL, executarTrabalhador, &trab[t]) == 0;
+    /* um trabalhador sem thread roda aqui: esvazia a sua fila e rouba das
+       demais, então nenhuma partida fica sem jogar mesmo se nenhuma subir */
+    int semThread = 0;
+    for (int t = 0; t < numThreads; ++t) {
+        if (trab[t].emThread) continue;
+        executarTrabalhador(&trab[t]);
+        semThread++;
+    }
+    for (int t = 0; t < numThreads; ++t)
+        if (trab[t].emThread) pthread_join(threads[t], NULL);
+    double decorrido = segundosMonotonicos() - inicio;
+    if (semThread)
+        fprintf(stderr, "Aviso: %d thread(s) não puderam ser criadas; seus trabalhadores rodaram na thread principal.\n", semThread);
+
+    /* mescla os resultados locais de cada trabalhador */
+    memset(total, 0, sizeof(*total));
+    *roubos = 0;
+    int falhas = 0;
+    for (int t = 0; t < numThreads; ++t) {
+        falhas += trab[t].falhou;
+        total->partidas += trab[t].est.partidas;
+        total->vitorias += trab[t].est.vitorias;
+        total->ataques += trab[t].est.ataques;
+        total->conquistas += trab[t].est.conquistas;
+        for (int k = 0; k < MISSAO_MAX_REGRAS; ++k) total->porTipo[k] += trab[t].est.porTipo[k];
+        *roubos += trab[t].roubos;
+    }
+    if (total->partidas != numPartidas) decorrido = -1.0;
+    else if (falhas)
+        fprintf(stderr, "Aviso: %d trabalhador(es) sem memória para a arena; as partidas deles foram jogadas pelos demais.\n", falhas);
+
+    free(filas);
+    free(trab);
+    free(threads);
+    return decorrido;
+}
+
+/* executarModoPartidas():
+   Modo não interativo: war --partidas N [--territorios N] [--cores N] [--threads N] [--semente N] [--sem-fronteiras]
+   Joga N partidas completas com 1, 2, ..., T threads (T = --threads ou o
+   número de núcleos) e imprime partidas/s, aceleração e as estatísticas.
+   Os territórios formam uma grade; --sem-fronteiras libera ataques entre quaisquer pares.
+   Com --log ARQ, só a última passada (T threads) é registrada.
+*/
+int executarModoPartidas(int argc, char *argv[]) {
+    long long numPartidas = lerOpcaoInteira(argc, argv, "--partidas", 100000);
+    int qtdTerritorios = (int) lerOpcaoInteira(argc, argv, "--territorios", 42);
+    int numCores = (int) lerOpcaoInteira(argc, argv, "--cores", 2);
+    int maxThreads = (int) lerOpcaoInteira(argc, argv, "--threads", sysconf(_SC_NPROCESSORS_ONLN));
+    uint64_t semente = (uint64_t) lerOpcaoInteira(argc, argv, "--semente", 1);
+
+    char coresDisponiveis[6][TAM_COR] = {
+        "Azul", "Vermelho", "Verde", "Amarelo", "Preto", "Branco"
+    };
+
+    if (numPartidas < 1 || numPartidas > UINT32_MAX || qtdTerritorios < 1 ||
+        numCores < 2 || numCores > 6 || maxThreads < 1) {
+        fprintf(stderr, "Uso: %s --partidas N [--territorios N] [--cores 2..6] [--threads N] [--semente N] [--sem-fronteiras]\n", argv[0]);
+        return 1;
+    }
+
+    Grafo *grafo = NULL;
+    if (!temOpcao(argc, argv, "--sem-fronteiras")) {
+        grafo = gerarGrafoGrade(qtdTerritorios);
+        if (!grafo) {
+            fprintf(stderr, "Falha na alocação de memória para as fronteiras.\n");
+            return 1;
+        }
+    }
+
+    printf("=== EXECUTOR PARALELO (%lld partidas, %d territórios, %d cores, semente %llu) ===\n",
+           numPartidas, qtdTerritorios, numCores, (unsigned long long) semente);
+    printf("%-8s %-12s %-14s %-10s %-10s %-8s %-12s\n", "THREADS", "TEMPO(s)", "PARTIDAS/s", "ACELER.",
+           "EFICIÊNCIA", "ROUBOS", "ALOC/PARTIDA");
+
+    double tempoBase = 0.0;
+    EstatisticaPartidas total;
+    for (int t = 1; t <= maxThreads; ++t) {
+        long long roubos = 0;
+        long long alocacoesAntes = alocacoesHeap();
+        double decorrido = executarPartidasParalelas(numPartidas, t, qtdTerritorios, numCores,
+                                                     coresDisponiveis, semente, grafo,
+                                                     logAtivo() && t == maxThreads, &total, &roubos);
+        if (decorrido < 0) {
+            fprintf(stderr, "Falha na alocação de memória para o executor paralelo.\n");
+            liberarGrafo(grafo);
+            return 1;
+        }
+        if (t == 1) tempoBase = decorrido;
+        double aceleracao = decorrido > 0 ? tempoBase / decorrido : 0.0;
+        /* desconta a arena de cada trabalhador (aquecimento, uma por thread) */
+        long long alocacoesPartidas = alocacoesHeap() - alocacoesAntes - t;
+        printf("%-8d %-12.3f %-14.0f %-10.2f %-10.2f %-8lld %-12.3f\n", t, decorrido,
+               decorrido > 0 ? (double) total.partidas / decorrido : 0.0,
+               aceleracao, aceleracao / t, roubos, (double) alocacoesPartidas / (double) total.partidas);
+    }
+
+    printf("\nVitórias: %lld de %lld (%.2f%%) | ataques/partida: %.2f | conquistas/partida: %.2f\n",
+           total.vitorias, total.partidas, 100.0 * (double) total.vitorias / (double) total.partidas,
+           (double) total.ataques / (double) total.partidas, (double) total.conquistas / (double) total.partidas);
+    const TabelaMissoes *tabela = tabelaMissoes();
+    printf("Vitórias por missão:");
+    for (int k = 0; k < tabela->numRegras; ++k)
+        printf(" %s=%lld", tabela->regras[k].nome, total.porTipo[k]);
+    printf("\n");
+    liberarGrafo(grafo);
+    return 0;
+}
+
+/* construirGrafo():
+   Monta o grafo CSR a partir de uma lista de arestas não direcionadas
+   (origens[k] -- destinos[k]) em duas passadas: conta graus, faz a soma de
+   prefixos e preenche. Retorna NULL em caso de falha de alocação.
+*/
+Grafo* construirGrafo(int n, const int *origens, const int *destinos, int64_t numArestas) {
+    Grafo *g = (Grafo*) memAlocarZerado(1, sizeof(Grafo));
+    if (!g) return NULL;
+    g->n = n;
+    g->numEntradas = 2 * numArestas;
+    g->inicio = (int64_t*) memAlocarZerado((size_t) n + 1, sizeof(int64_t));
+    g->vizinhos = (int*) memAlocar((size_t) (g->numEntradas > 0 ? g->numEntradas : 1) * sizeof(int));
+    if (!g->inicio || !g->vizinhos) {
+        liberarGrafo(g);
+        return NULL;
+    }
+
+    for (int64_t k = 0; k < numArestas; ++k) {
+        g->inicio[origens[k] + 1]++;
+        g->inicio[destinos[k] + 1]++;
+    }
+    for (int i = 0; i < n; ++i)
+        g->inicio[i + 1] += g->inicio[i];
+
+    /* usa inicio[i] como cursor de escrita e depois restaura */
+    for (int64_t k = 0; k < numArestas; ++k) {
+        g->vizinhos[g->inicio[origens[k]]++] = destinos[k];
+        g->vizinhos[g->inicio[destinos[k]]++] = origens[k];
+    }
+    for (int i = n; i > 0; --i)
+        g->inicio[i] = g->inicio[i - 1];
+    g->inicio[0] = 0;
+    return g;
+}
+
+/* gerarGrafoGrade():
+   Fronteiras de uma grade com largura ceil(sqrt(n)): cada território faz
+   fronteira com os vizinhos de cima, baixo, esquerda e direita.
+*/
+Grafo* gerarGrafoGrade(int n) {
+    int largura = 1;
+    while ((long long) largura * largura < n) largura++;
+
+    Grafo *g = (Grafo*) memAlocarZerado(1, sizeof(Grafo));
+    if (!g) return NULL;
+    g->n = n;
+    g->inicio = (int64_t*) memAlocarZerado((size_t) n + 1, sizeof(int64_t));
+    g->vizinhos = (int*) memAlocar(((size_t) n * 4 + 1) * sizeof(int));
+    if (!g->inicio || !g->vizinhos) {
+        liberarGrafo(g);
+        return NULL;
+    }
+
+    int64_t e = 0;
+    for (int i = 0; i < n; ++i) {
+        int coluna = i % largura;
+        g->inicio[i] = e;
+        if (i - largura >= 0) g->vizinhos[e++] = i - largura;
+        if (coluna > 0) g->vizinhos[e++] = i - 1;
+        if (coluna < largura - 1 && i + 1 < n) g->vizinhos[e++] = i + 1;
+        if (i + largura < n) g->vizinhos[e++] = i + largura;
+    }
+    g->inicio[n] = e;
+    g->numEntradas = e;
+    return g;
+}
+
+/* gerarGrafoAleatorio():
+   Mundo gerado: um anel (garante conectividade) mais cordas aleatórias até o
+   grau médio pedido. Arestas repetidas são raras e inofensivas.
+*/
+Grafo* gerarGrafoAleatorio(int n, int grauMedio, GeradorAleatorio *rng) {
+    if (n < 2) return construirGrafo(n, NULL, NULL, 0);
+    int64_t numArestas = (int64_t) n * (grauMedio > 2 ? grauMedio : 2) / 2;
+    int *origens = (int*) memAlocar((size_t) numArestas * sizeof(int));
+    int *destinos = (int*) memAlocar((size_t) numArestas * sizeof(int));
+    if (!origens || !destinos) {
+        free(origens); free(destinos);
+        return NULL;
+    }
+
+    for (int i = 0; i < n; ++i) {
+        origens[i] = i;
+        destinos[i] = (i + 1) % n;
+    }
+    for (int64_t k = n; k < numArestas; ++k) {
+        int a = (int) rngIntervalo(rng, (uint32_t) n);
+        int b = (int) rngIntervalo(rng, (uint32_t) (n - 1));
+        origens[k] = a;
+        destinos[k] = (b >= a) ? b + 1 : b; /* evita laço a -- a */
+    }
+
+    Grafo *g = construirGrafo(n, origens, destinos, numArestas);
+    free(origens);
+    free(destinos);
+    return g;
+}
+
+/* liberarGrafo():
+   Libera o grafo e seus vetores.
+*/
+void liberarGrafo(Grafo *grafo) {
+    if (!grafo) return;
+    free(grafo->inicio);
+    free(grafo->vizinhos);
+    free(grafo);
+}
+
+/* saoVizinhos():
+   Retorna 1 se a e b fazem fronteira (varre a lista de a: O(grau)).
+   Sem grafo, qualquer par de territórios é considerado vizinho.
+*/
+int saoVizinhos(const Mapa *mapa, int a, int b) {
+    const Grafo *g = mapa->grafo;
+    if (!g) return 1;
+    for (int64_t e = g->inicio[a]; e < g->inicio[a + 1]; ++e)
+        if (g->vizinhos[e] == b) return 1;
+    return 0;
+}
+
+/* escolherVizinhoInimigo():
+   Sorteia um vizinho de idx que não seja da cor 'cor' (começa em posição
+   aleatória da lista e percorre em círculo). Sem grafo, faz alguns sorteios no
+   mapa inteiro e depois uma varredura. Retorna -1 se não houver.
+*/
+int escolherVizinhoInimigo(const Mapa *mapa, int idx, int cor, GeradorAleatorio *rng) {
+    const Grafo *g = mapa->grafo;
+    if (g) {
+        int64_t base = g->inicio[idx];
+        int grau = (int) (g->inicio[idx + 1] - base);
+        if (grau == 0) return -1;
+        int partida = (int) rngIntervalo(rng, (uint32_t) grau);
+        for (int k = 0; k < grau; ++k) {
+            int v = g->vizinhos[base + (partida + k) % grau];
+            if (mapa->dono[v] != cor) return v;
+        }
+        return -1;
+    }
+
+    int qtd = mapa->qtd;
+    int partida = (int) rngIntervalo(rng, (uint32_t) qtd);
+    for (int k = 0; k < qtd + 8; ++k) {
+        int v = (k < 8) ? (int) rngIntervalo(rng, (uint32_t) qtd) : (partida + k - 8) % qtd;
+        if (mapa->dono[v] != cor) return v;
+    }
+    return -1;
+}
+
+/* listarFronteira():
+   Territórios da cor 'cor' que fazem fronteira com ao menos um inimigo.
+   Escreve os índices em 'saida' (se não for NULL) e retorna a quantidade.
+   Custo O(territórios + arestas), com saída antecipada por território.
+*/
+int listarFronteira(const Mapa *mapa, int cor, int *saida) {
+    const Grafo *g = mapa->grafo;
+    int cont = 0;
+    for (int i = 0; i < mapa->qtd; ++i) {
+        if (mapa->dono[i] != cor) continue;
+        int fronteira = 0;
+        if (g) {
+            for (int64_t e = g->inicio[i]; e < g->inicio[i + 1] && !fronteira; ++e)
+                fronteira = mapa->dono[g->vizinhos[e]] != cor;
+        } else {
+            fronteira = mapa->territoriosPorCor[cor] < mapa->qtd;
+        }
+        if (fronteira) {
+            if (saida) saida[cont] = i;
+            cont++;
+        }
+    }
+    return cont;
+}
+
+/* analisarComponentes():
+   Para cada cor, conta os componentes conexos (territórios da mesma cor
+   ligados por fronteira) e o tamanho do maior. Busca em largura iterativa com
+   fila e bitmap de visitados; cada nó e aresta é visto uma vez. Os buffers
+   temporários saem de 'rascunho' (se não for NULL, devolvidos ao final) ou do heap.
+   Retorna 0 em caso de sucesso e -1 se faltar memória.
+*/
+int analisarComponentes(const Mapa *mapa, ComponentesCor saida[MAX_CORES], Arena *rascunho) {
+    memset(saida, 0, sizeof(ComponentesCor) * MAX_CORES);
+    const Grafo *g = mapa->grafo;
+    if (!g) {
+        /* sem fronteiras: cada cor forma um único bloco */
+        for (int c = 0; c < MAX_CORES; ++c) {
+            saida[c].componentes = mapa->territoriosPorCor[c] > 0;
+            saida[c].maior = (int) mapa->territoriosPorCor[c];
+        }
+        return 0;
+    }
+
+    int n = mapa->qtd;
+    size_t marca = rascunho ? arenaMarca(rascunho) : 0;
+    int *fila;
+    uint8_t *visitado;
+    if (rascunho) {
+        fila = (int*) arenaAlocar(rascunho, (size_t) n * sizeof(int));
+        visitado = (uint8_t*) arenaAlocar(rascunho, (size_t) n / 8 + 1);
+        if (!fila || !visitado) {
+            arenaRestaurar(rascunho, marca);
+            return -1;
+        }
+        memset(visitado, 0, (size_t) n / 8 + 1);
+    } else {
+        fila = (int*) memAlocar((size_t) (n > 0 ? n : 1) * sizeof(int));
+        visitado = (uint8_t*) memAlocarZerado((size_t) n / 8 + 1, 1);
+        if (!fila || !visitado) {
+            free(fila); free(visitado);
+            return -1;
+        }
+    }
+
+    for (int s = 0; s < n; ++s) {
+        if (visitado[s >> 3] & (1u << (s & 7))) continue;
+        int cor = mapa->dono[s];
+        int cabeca = 0, cauda = 0;
+        fila[cauda++] = s;
+        visitado[s >> 3] |= (uint8_t) (1u << (s & 7));
+        while (cabeca < cauda) {
+            int u = fila[cabeca++];
+            for (int64_t e = g->inicio[u]; e < g->inicio[u + 1]; ++e) {
+                int v = g->vizinhos[e];
+                if (mapa->dono[v] != cor || (visitado[v >> 3] & (1u << (v & 7)))) continue;
+                visitado[v >> 3] |= (uint8_t) (1u << (v & 7));
+                fila[cauda++] = v;
+            }
+        }
+        saida[cor].componentes++;
+        if (cauda > saida[cor].maior) saida[cor].maior = cauda;
+    }
+
+    if (rascunho) {
+        arenaRestaurar(rascunho, marca);
+    } else {
+        free(fila);
+        free(visitado);
+    }
+    return 0;
+}
+
+/* executarBenchGrafo():
+   Benchmark: war --bench-grafo [--nos N] [--grau D] [--semente N]
+   Gera um mundo aleatório (padrão: 1M territórios, grau médio 20, ou seja,
+   20M entradas de adjacência) e mede a construção do CSR, validações de
+   ataque, a lista de fronteira e os componentes conexos por cor.
+*/
+int executarBenchGrafo(int argc, char *argv[]) {
+    int n = (int) lerOpcaoInteira(argc, argv, "--nos", 1000000);
+    int grau = (int) lerOpcaoInteira(argc, argv, "--grau", 20);
+    GeradorAleatorio rng;
+    rngSemear(&rng, (uint64_t) lerOpcaoInteira(argc, argv, "--semente", 1));
+    if (n < 2 || grau < 2) {
+        fprintf(stderr, "Uso: %s --bench-grafo [--nos N>=2] [--grau D>=2] [--semente N]\n", argv[0]);
+        return 1;
+    }
+
+    char cores[MAX_CORES][TAM_COR] = { "Azul", "Vermelho", "Verde", "Amarelo", "Preto", "Branco" };
+    Mapa *mapa = alocarMapa(n, 0);
+    int *fronteira = (int*) memAlocar((size_t) n * sizeof(int));
+    double t0 = segundosMonotonicos();
+    Grafo *g = gerarGrafoAleatorio(n, grau, &rng);
+    double tConstrucao = segundosMonotonicos() - t0;
+    if (!mapa || !fronteira || !g) {
+        fprintf(stderr, "Falha na alocação de memória para o benchmark de grafo.\n");
+        liberarMemoria(mapa, NULL); free(fronteira); liberarGrafo(g);
+        return 1;
+    }
+    inicializarTerritorios(mapa, cores, MAX_CORES, &rng);
+    /* embaralha os donos para ter fronteiras irregulares */
+    for (int i = 0; i < n; ++i)
+        atualizarTerritorio(mapa, i, (int) rngIntervalo(&rng, MAX_CORES), mapa->tropas[i]);
+    mapa->grafo = g;
+
+    printf("=== BENCHMARK DE FRONTEIRAS (%d territórios, %lld entradas CSR) ===\n", n, (long long) g->numEntradas);
+    printf("Construção do CSR: %.3f s (%.1f M arestas/s)\n", tConstrucao,
+           (double) g->numEntradas / 2 / tConstrucao / 1e6);
+
+    /* validações de ataque: metade entre vizinhos, metade entre pares aleatórios */
+    const int numValidacoes = 10000000;
+    long long validos = 0;
+    t0 = segundosMonotonicos();
+    for (int k = 0; k < numValidacoes; ++k) {
+        int a = (int) rngIntervalo(&rng, (uint32_t) n);
+        int64_t grauA = g->inicio[a + 1] - g->inicio[a];
+        int b = (k & 1) ? (int) rngIntervalo(&rng, (uint32_t) n)
+                        : g->vizinhos[g->inicio[a] + (int64_t) rngIntervalo(&rng, (uint32_t) grauA)];
+        validos += validarAtaque(mapa, a, b, mapa->dono[a]) == ATAQUE_OK;
+    }
+    double tValidacao = segundosMonotonicos() - t0;
+    printf("Validação de ataque: %.1f ns/op (%lld válidos de %d)\n",
+           tValidacao * 1e9 / numValidacoes, validos, numValidacoes);
+
+    t0 = segundosMonotonicos();
+    int numFronteira = listarFronteira(mapa, 0, fronteira);
+    double tFronteira = segundosMonotonicos() - t0;
+    printf("Fronteira de %s: %d territórios em %.3f ms\n", mapa->cores[0], numFronteira, tFronteira * 1e3);
+
+    ComponentesCor comp[MAX_CORES];
+    t0 = segundosMonotonicos();
+    int ok = analisarComponentes(mapa, comp, NULL);
+    double tComp = segundosMonotonicos() - t0;
+    if (ok == 0) {
+        printf("Componentes por cor em %.3f ms:\n", tComp * 1e3);
+        for (int c = 0; c < mapa->numCores; ++c)
+            printf("  %-10s territórios=%-10lld componentes=%-8d maior=%d\n", mapa->cores[c],
+                   mapa->territoriosPorCor[c], comp[c].componentes, comp[c].maior);
+    }
+
+    liberarMemoria(mapa, NULL);
+    liberarGrafo(g);
+    free(fronteira);
+    return ok == 0 ? 0 : 1;
+}
+
+/* escreverVetores():
+   writev() de todos os vetores, repetindo em escrita parcial (em grupos de
+   até 1024 vetores). Altera iov[]. Retorna 0 ou -1 (com errno da falha).
+*/
+static int escreverVetores(int fd, struct iovec *iov, int numIov) {
+    int iovAtual = 0;
+    while (iovAtual < numIov) {
+        ssize_t escrito = writev(fd, iov + iovAtual, numIov - iovAtual > 1024 ? 1024 : numIov - iovAtual);
+        if (escrito < 0) return -1;
+        while (iovAtual < numIov && (size_t) escrito >= iov[iovAtual].iov_len) {
+            escrito -= (ssize_t) iov[iovAtual].iov_len;
+            iovAtual++;
+        }
+        if (iovAtual < numIov) {
+            iov[iovAtual].iov_base = (uint8_t*) iov[iovAtual].iov_base + escrito;
+            iov[iovAtual].iov_len -= (size_t) escrito;
+        }
+    }
+    return 0;
+}
+
+/* alinharSnapshot():
+   Arredonda um deslocamento para o próximo múltiplo de SNAPSHOT_ALINHAMENTO.
+*/
+static uint64_t alinharSnapshot(uint64_t deslocamento) {
+    return (deslocamento + SNAPSHOT_ALINHAMENTO - 1) & ~(uint64_t) (SNAPSHOT_ALINHAMENTO - 1);
+}
+
+/* somaSnapshot():
+   Soma de verificação de 64 bits de 'tam' bytes, encadeável por 'soma'
+   (a soma das seções passa a de uma para a seguinte). Quatro acumuladores
+   independentes de 8 bytes mantêm a varredura perto da banda de memória.
+   Detecta corrupção acidental; não é uma assinatura contra adulteração.
+*/
+static uint64_t somaSnapshot(const void *dados, size_t tam, uint64_t soma) {
+    const uint64_t P1 = 0x9E3779B185EBCA87ULL, P2 = 0xC2B2AE3D27D4EB4FULL;
+    const uint8_t *p = (const uint8_t*) dados;
+    uint64_t v[4] = { soma + P1, soma ^ P2, soma - P1, ~soma };
+    size_t k = 0;
+    for (; k + 32 <= tam; k += 32) {
+        for (int j = 0; j < 4; ++j) {
+            uint64_t w;
+            memcpy(&w, p + k + 8 * j, sizeof(w));
+            v[j] += w * P2;
+            v[j] = ((v[j] << 31) | (v[j] >> 33)) * P1;
+        }
+    }
+    uint64_t h = (uint64_t) tam;
+    for (int j = 0; j < 4; ++j) h = (h ^ v[j]) * P1 + P2;
+    for (; k < tam; ++k) h = (h ^ p[k]) * 0x100000001B3ULL;
+    h ^= h >> 33;
+    h *= P2;
+    h ^= h >> 29;
+    return h;
+}
+
+/* salvarSnapshot():
+   Grava o mapa (com nomes e fronteiras, se houver) e a missão no formato
+   binário. A imagem empacotada vai ao disco com uma única chamada writev()
+   (cabeçalho + seções + preenchimento, sem cópia intermediária) em um arquivo
+   temporário, que recebe fsync() e só então é renomeado sobre o destino:
+   uma queda no meio da gravação nunca deixa um snapshot truncado. As somas
+   de verificação das seções e do cabeçalho são calculadas antes da escrita.
+   Retorna 0 em caso de sucesso e -1 em caso de erro (com mensagem).
+*/
+int salvarSnapshot(const char *caminho, const Mapa *mapa, const Missao *missao, int corJogador) {
+    _Static_assert(sizeof(int) == 4, "o snapshot assume int de 32 bits");
+    static const uint8_t zeros[SNAPSHOT_ALINHAMENTO] = { 0 };
+
+    CabecalhoSnapshot cab;
+    memset(&cab, 0, sizeof(cab));
+    memcpy(cab.magica, SNAPSHOT_MAGICA, sizeof(SNAPSHOT_MAGICA));
+    cab.versao = SNAPSHOT_VERSAO;
+    cab.qtd = mapa->qtd;
+    cab.numCores = mapa->numCores;
+    cab.corJogador = corJogador;
+    memcpy(cab.cores, mapa->cores, sizeof(cab.cores));
+    for (int c = 0; c < MAX_CORES; ++c) {
+        cab.territoriosPorCor[c] = mapa->territoriosPorCor[c];
+        cab.tropasPorCor[c] = mapa->tropasPorCor[c];
+    }
+    if (missao) {
+        cab.flags |= SNAPSHOT_TEM_MISSAO;
+        cab.missaoTipo = missao->tipo;
+        cab.missaoAlvoNumero = missao->alvoNumero;
+        cab.missaoAlvoCor = missao->alvoCor;
+        memcpy(cab.missaoDescricao, missao->descricao, sizeof(cab.missaoDescricao));
+        cab.missaoNumTermos = missao->numTermos;
+        memcpy(cab.missaoTermos, missao->termos, sizeof(cab.missaoTermos));
+    }
+
+    /* monta a lista de seções (ponteiro, tamanho) e seus deslocamentos */
+    const Grafo *g = mapa->grafo;
+    size_t n = (size_t) mapa->qtd;
+    struct { const void *dados; uint64_t tamanho; uint64_t *off; } secoes[5] = {
+        { mapa->dono, n * sizeof(uint8_t), &cab.offDono },
+        { mapa->tropas, n * sizeof(int), &cab.offTropas },
+        { mapa->nomes, mapa->nomes ? n * TAM_NOME : 0, &cab.offNomes },
+        { g ? g->inicio : NULL, g ? (n + 1) * sizeof(int64_t) : 0, &cab.offInicio },
+        { g ? g->vizinhos : NULL, g ? (uint64_t) g->numEntradas * sizeof(int) : 0, &cab.offVizinhos },
+    };
+    if (mapa->nomes) cab.flags |= SNAPSHOT_TEM_NOMES;
+    if (g) {
+        cab.flags |= SNAPSHOT_TEM_GRAFO;
+        cab.numEntradasGrafo = g->numEntradas;
+    }
+
+    struct iovec iov[12];
+    int numIov = 1;
+    uint64_t deslocamento = sizeof(cab);
+    for (int k = 0; k < 5; ++k) {
+        if (secoes[k].tamanho == 0) continue;
+        uint64_t alinhado = alinharSnapshot(deslocamento);
+        if (alinhado > deslocamento) {
+            iov[numIov].iov_base = (void*) zeros;
+            iov[numIov++].iov_len = (size_t) (alinhado - deslocamento);
+        }
+        *secoes[k].off = alinhado;
+        iov[numIov].iov_base = (void*) secoes[k].dados;
+        iov[numIov++].iov_len = (size_t) secoes[k].tamanho;
+        deslocamento = alinhado + secoes[k].tamanho;
+        cab.somaSecoes = somaSnapshot(secoes[k].dados, (size_t) secoes[k].tamanho, cab.somaSecoes);
+    }
+    cab.tamanhoTotal = deslocamento;
+    cab.somaCabecalho = somaSnapshot(&cab, sizeof(cab), 0);
+    iov[0].iov_base = &cab;
+    iov[0].iov_len = sizeof(cab);
+
+    /* caminho longo demais: falha antes de criar qualquer arquivo (um nome
+       truncado poderia cair em outro lugar); daqui em diante 'caminho' cabe
+       também em 'diretorio', que tem o mesmo tamanho */
+    char temporario[4096];
+    int tamTemporario = snprintf(temporario, sizeof(temporario), "%s.tmp.%ld", caminho, (long) getpid());
+    if (tamTemporario < 0 || (size_t) tamTemporario >= sizeof(temporario)) {
+        fprintf(stderr, "Caminho longo demais para o snapshot: %.60s...\n", caminho);
+        return -1;
+    }
+    int fd = open(temporario, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        perror("Falha ao criar o snapshot");
+        return -1;
+    }
+
+    /* uma única writev(); só repete em escrita parcial (arquivos enormes) */
+    if (escreverVetores(fd, iov, numIov) != 0) {
+        perror("Falha ao gravar o snapshot");
+        close(fd);
+        unlink(temporario);
+        return -1;
+    }
+
+    if (fsync(fd) != 0 || close(fd) != 0 || rename(temporario, caminho) != 0) {
+        perror("Falha ao finalizar o snapshot");
+        unlink(temporario);
+        return -1;
+    }
+
+    /* torna o rename durável: fsync do diretório que contém o arquivo */
+    char diretorio[4096];
+    snprintf(diretorio, sizeof(diretorio), "%s", caminho);
+    char *barra = strrchr(diretorio, '/');
+    if (barra) *(barra == diretorio ? barra + 1 : barra) = '\0'; else strcpy(diretorio, ".");
+    int fdDir = open(diretorio, O_RDONLY);
+    if (fdDir >= 0) {
+        fsync(fdDir);
+        close(fdDir);
+    }
+    return 0;
+}
+
+/* validarConteudoSnapshot():
+   Validação completa (só com --validar): confere o conteúdo mapeado, que o
+   resto do jogo usa como índice sem checar — dono < numCores, tropas >= 0,
+   nomes terminados em '\0' e o grafo CSR (inicio[] de 0 a numEntradas sem
+   decrescer, vizinhos[] < qtd) — em uma única passada por território, que
+   também recalcula os agregados e os compara com os salvos.
+   Retorna 1 se o conteúdo é válido, 0 caso contrário.
+*/
+static int validarConteudoSnapshot(const Mapa *mapa, const Grafo *grafo) {
+    long long territorios[MAX_CORES] = { 0 }, tropas[MAX_CORES] = { 0 };
+    if (grafo && (grafo->inicio[0] != 0 || grafo->inicio[grafo->n] != grafo->numEntradas)) return 0;
+    for (int i = 0; i < mapa->qtd; ++i) {
+        int dono = mapa->dono[i];
+        if (dono >= mapa->numCores || mapa->tropas[i] < 0) return 0;
+        territorios[dono]++;
+        tropas[dono] += mapa->tropas[i];
+        if (mapa->nomes && !memchr(mapa->nomes[i], '\0', TAM_NOME)) return 0;
+        if (grafo) {
+            int64_t a = grafo->inicio[i], b = grafo->inicio[i + 1];
+            if (b < a || b > grafo->numEntradas) return 0;
+            for (int64_t e = a; e < b; ++e)
+                if (grafo->vizinhos[e] < 0 || grafo->vizinhos[e] >= grafo->n) return 0;
+        }
+    }
+    for (int c = 0; c < MAX_CORES; ++c)
+        if (territorios[c] != mapa->territoriosPorCor[c] || tropas[c] != mapa->tropasPorCor[c]) return 0;
+    return 1;
+}
+
+/* carregarSnapshot():
+   Abre um snapshot com mmap privado e aponta o mapa, o grafo e a missão
+   direto para as seções do arquivo, sem copiar nem converter registros:
+   confere o cabeçalho (soma, limites das seções, missão e agregados salvos)
+   e não varre o mapa. Com 'validar' (--validar) confere também a soma das
+   seções e o conteúdo com validarConteudoSnapshot(), ao custo de percorrer
+   o arquivo. Retorna 0 em caso de sucesso e -1 em caso de erro (com mensagem).
+*/
+int carregarSnapshot(const char *caminho, Snapshot *snap, int validar) {
+    memset(snap, 0, sizeof(*snap));
+    int fd = open(caminho, O_RDONLY);
+    if (fd < 0) {
+        perror("Falha ao abrir o snapshot");
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(CabecalhoSnapshot)) {
+        fprintf(stderr, "Snapshot inválido: %s\n", caminho);
+        close(fd);
+        return -1;
+    }
+    void *base = mmap(NULL, (size_t) st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        perror("Falha no mmap do snapshot");
+        return -1;
+    }
+
+    const CabecalhoSnapshot *cab = (const CabecalhoSnapshot*) base;
+    CabecalhoSnapshot semSoma = *cab;
+    semSoma.somaCabecalho = 0;
+    uint64_t tamanho = (uint64_t) st.st_size;
+    uint64_t n = (uint64_t) cab->qtd;
+    int valido = memcmp(cab->magica, SNAPSHOT_MAGICA, sizeof(SNAPSHOT_MAGICA)) == 0 &&
+                 cab->versao == SNAPSHOT_VERSAO && cab->tamanhoTotal == tamanho &&
+                 somaSnapshot(&semSoma, sizeof(semSoma), 0) == cab->somaCabecalho &&
+                 cab->qtd > 0 && cab->qtd <= INT32_MAX &&
+                 cab->numCores > 0 && cab->numCores <= MAX_CORES &&
+                 cab->corJogador >= 0 && cab->corJogador < cab->numCores &&
+                 cab->offDono <= tamanho && n <= tamanho - cab->offDono &&
+                 cab->offTropas % sizeof(int) == 0 && cab->offTropas <= tamanho &&
+                 n <= (tamanho - cab->offTropas) / sizeof(int);
+    if (valido && (cab->flags & SNAPSHOT_TEM_NOMES))
+        valido = cab->offNomes <= tamanho && n <= (tamanho - cab->offNomes) / TAM_NOME;
+    if (valido && (cab->flags & SNAPSHOT_TEM_GRAFO))
+        valido = cab->offInicio % sizeof(int64_t) == 0 && cab->offInicio <= tamanho &&
+                 n + 1 <= (tamanho - cab->offInicio) / sizeof(int64_t) &&
+                 cab->offVizinhos % sizeof(int) == 0 && cab->offVizinhos <= tamanho &&
+                 cab->numEntradasGrafo >= 0 &&
+                 (uint64_t) cab->numEntradasGrafo <= (tamanho - cab->offVizinhos) / sizeof(int);
+    if (valido && (cab->flags & SNAPSHOT_TEM_MISSAO)) {
+        valido = cab->missaoTipo >= 0 && cab->missaoTipo < MISSAO_MAX_REGRAS &&
+                 cab->missaoNumTermos >= 1 && cab->missaoNumTermos <= MISSAO_MAX_TERMOS;
+        for (int k = 0; valido && k < cab->missaoNumTermos; ++k) {
+            const TermoMissao *t = &cab->missaoTermos[k];
+            valido = t->campo <= MISSAO_CAMPO_TROPAS && (t->sinal == 1 || t->sinal == -1) &&
+                     (t->cor == MISSAO_COR_JOGADOR || t->cor < cab->numCores);
+        }
+        valido = valido && (cab->missaoAlvoCor == COR_NENHUMA ||
+                            (cab->missaoAlvoCor >= 0 && cab->missaoAlvoCor < cab->numCores));
+    }
+    /* agregados salvos: cores inexistentes zeradas e contagens somando qtd */
+    int64_t somaTerritorios = 0;
+    for (int c = 0; valido && c < MAX_CORES; ++c) {
+        valido = cab->territoriosPorCor[c] >= 0 && cab->tropasPorCor[c] >= 0 &&
+                 (c < cab->numCores || (cab->territoriosPorCor[c] == 0 && cab->tropasPorCor[c] == 0));
+        somaTerritorios += cab->territoriosPorCor[c];
+    }
+    valido = valido && somaTerritorios == cab->qtd;
+    if (!valido) {
+        fprintf(stderr, "Snapshot inválido ou de versão incompatível: %s\n", caminho);
+        munmap(base, (size_t) tamanho);
+        return -1;
+    }
+
+    snap->base = base;
+    snap->tamanho = (size_t) tamanho;
+    uint8_t *bytes = (uint8_t*) base;
+
+    Mapa *mapa = &snap->mapa;
+    mapa->qtd = (int) cab->qtd;
+    mapa->dono = bytes + cab->offDono;
+    mapa->tropas = (int*) (bytes + cab->offTropas);
+    mapa->nomes = (cab->flags & SNAPSHOT_TEM_NOMES) ? (char (*)[TAM_NOME]) (bytes + cab->offNomes) : NULL;
+    mapa->numCores = cab->numCores;
+    memcpy(mapa->cores, cab->cores, sizeof(mapa->cores));
+    for (int c = 0; c < MAX_CORES; ++c) mapa->cores[c][TAM_COR - 1] = '\0';
+    if (cab->flags & SNAPSHOT_TEM_GRAFO) {
+        snap->grafo.n = mapa->qtd;
+        snap->grafo.numEntradas = cab->numEntradasGrafo;
+        snap->grafo.inicio = (int64_t*) (bytes + cab->offInicio);
+        snap->grafo.vizinhos = (int*) (bytes + cab->offVizinhos);
+        mapa->grafo = &snap->grafo;
+    }
+    for (int c = 0; c < MAX_CORES; ++c) {
+        mapa->territoriosPorCor[c] = cab->territoriosPorCor[c];
+        mapa->tropasPorCor[c] = cab->tropasPorCor[c];
+    }
+    if (validar) {
+        uint64_t soma = 0;
+        const struct { uint64_t off, tamanho; } secoes[5] = {
+            { cab->offDono, n },
+            { cab->offTropas, n * sizeof(int) },
+            { cab->offNomes, mapa->nomes ? n * TAM_NOME : 0 },
+            { cab->offInicio, mapa->grafo ? (n + 1) * sizeof(int64_t) : 0 },
+            { cab->offVizinhos, mapa->grafo ? (uint64_t) cab->numEntradasGrafo * sizeof(int) : 0 },
+        };
+        for (int k = 0; k < 5; ++k)
+            if (secoes[k].tamanho) soma = somaSnapshot(bytes + secoes[k].off, (size_t) secoes[k].tamanho, soma);
+        if (soma != cab->somaSecoes || !validarConteudoSnapshot(mapa, mapa->grafo)) {
+            fprintf(stderr, "Snapshot com conteúdo inválido: %s\n", caminho);
+            fecharSnapshot(snap);
+            return -1;
+        }
+    }
+
+    snap->corJogador = cab->corJogador;
+    snap->temMissao = (cab->flags & SNAPSHOT_TEM_MISSAO) != 0;
+    if (snap->temMissao) {
+        snap->missao.tipo = cab->missaoTipo;
+        snap->missao.alvoNumero = cab->missaoAlvoNumero;
+        snap->missao.alvoCor = cab->missaoAlvoCor;
+        memcpy(snap->missao.descricao, cab->missaoDescricao, sizeof(snap->missao.descricao));
+        snap->missao.descricao[sizeof(snap->missao.descricao) - 1] = '\0';
+        snap->missao.numTermos = cab->missaoNumTermos;
+        memcpy(snap->missao.termos, cab->missaoTermos, sizeof(snap->missao.termos));
+    }
+    return 0;
+}
+
+/* fecharSnapshot():
+   Desfaz o mapeamento de um snapshot aberto por carregarSnapshot().
+*/
+void fecharSnapshot(Snapshot *snap) {
+    if (snap->base) munmap(snap->base, snap->tamanho);
+    memset(snap, 0, sizeof(*snap));
+}
+
+/* executarGerarSnapshot():
+   Modo não interativo: war --gerar-snapshot ARQ [--territorios N] [--cores N]
+                        [--semente N] [--com-nomes] [--com-fronteiras]
+   Gera um mapa procedural, salva-o em ARQ e reabre o arquivo, imprimindo os
+   tempos de gravação, de abertura com validação completa e de abertura
+   simples (mmap).
+*/
+int executarGerarSnapshot(int argc, char *argv[]) {
+    const char *caminho = lerOpcaoTexto(argc, argv, "--gerar-snapshot", NULL);
+    long long qtd = lerOpcaoInteira(argc, argv, "--territorios", 1000000);
+    int numCores = (int) lerOpcaoInteira(argc, argv, "--cores", 2);
+    GeradorAleatorio rng;
+    rngSemear(&rng, (uint64_t) lerOpcaoInteira(argc, argv, "--semente", 1));
+    char cores[MAX_CORES][TAM_COR] = { "Azul", "Vermelho", "Verde", "Amarelo", "Preto", "Branco" };
+
+    if (!caminho || qtd < 1 || qtd > INT32_MAX || numCores < 2 || numCores > MAX_CORES) {
+        fprintf(stderr, "Uso: %s --gerar-snapshot ARQ [--territorios N] [--cores 2..6] [--semente N] [--com-nomes] [--com-fronteiras]\n", argv[0]);
+        return 1;
+    }
+
+    Mapa *mapa = alocarMapa((int) qtd, temOpcao(argc, argv, "--com-nomes"));
+    Grafo *grafo = temOpcao(argc, argv, "--com-fronteiras") ? gerarGrafoGrade((int) qtd) : NULL;
+    if (!mapa || (temOpcao(argc, argv, "--com-fronteiras") && !grafo)) {
+        fprintf(stderr, "Falha na alocação de memória para o mapa.\n");
+        liberarMemoria(mapa, NULL);
+        liberarGrafo(grafo);
+        return 1;
+    }
+    inicializarTerritorios(mapa, cores, numCores, &rng);
+    mapa->grafo = grafo;
+    int corJogador = internarCor(mapa, cores[0]);
+    Missao *missao = sortearMissao(mapa, corJogador, &rng, NULL);
+
+    double inicio = segundosMonotonicos();
+    int erro = salvarSnapshot(caminho, mapa, missao, corJogador);
+    double tSalvar = segundosMonotonicos() - inicio;
+
+    Snapshot snap;
+    double tCarregar = 0.0, tValidar = 0.0;
+    if (!erro) {
+        inicio = segundosMonotonicos();
+        erro = carregarSnapshot(caminho, &snap, 1);
+        tValidar = segundosMonotonicos() - inicio;
+        if (!erro) fecharSnapshot(&snap);
+    }
+    if (!erro) {
+        inicio = segundosMonotonicos();
+        erro = carregarSnapshot(caminho, &snap, 0);
+        tCarregar = segundosMonotonicos() - inicio;
+    }
+    if (!erro) {
+        int confere = snap.mapa.territoriosPorCor[corJogador] == mapa->territoriosPorCor[corJogador] &&
+                      snap.mapa.tropas[snap.mapa.qtd - 1] == mapa->tropas[mapa->qtd - 1];
+        printf("Snapshot %s: %lld territórios, %.1f MB\n", caminho, qtd, (double) snap.tamanho / 1e6);
+        printf("Gravação: %.3f s (%.1f MB/s) | abertura (mmap): %.3f ms | com --validar: %.3f ms | conteúdo %s\n",
+               tSalvar, (double) snap.tamanho / 1e6 / tSalvar, tCarregar * 1e3, tValidar * 1e3,
+               confere ? "confere" : "DIVERGENTE");
+        fecharSnapshot(&snap);
+        erro = !confere;
+    }
+
+    liberarMemoria(mapa, missao);
+    liberarGrafo(grafo);
+    return erro ? 1 : 0;
+}
+
+/* Nó da árvore da IA. A árvore é "open-loop": um nó representa a sequência
+   de jogadas da IA desde a raiz, não um estado — os dados e as respostas dos
+   oponentes são sorteados de novo a cada iteração. Por isso um filho pode ser
+   ilegal no estado sorteado da vez e é então ignorado na seleção. */
+typedef struct NoIA {
+    int origem, destino;
+    int visitas;
+    double soma;
+    int expandido;
+    int numFilhos;
+    struct NoIA *filhos;
+} NoIA;
+
+/* Contexto de uma thread da busca: cópia privada do mapa, diário e árvore */
+typedef struct {
+    ContextoIA *ia;
+    const Mapa *raiz;
+    int cor;
+    double prazo;           /* instante-limite (segundosMonotonicos) */
+    long long maxIteracoes; /* 0 = até o prazo */
+    GeradorAleatorio rng;
+    Arena arena;
+    size_t marca;           /* arena logo após o mapa: cada busca volta a ela */
+    Mapa *mapa;
+    NoIA no;                /* raiz da árvore */
+    Diario diario;          /* ligado a 'mapa': cada playout é desfeito por ele */
+    RegistroDiario registros[IA_MAX_DIARIO];
+    long long playouts;
+    int emThread;           /* 1 = tem thread própria (precisa de join) */
+} TrabalhadorIA;
+
+/* Oponentes de uma partida: os trabalhadores (arena, cópia do mapa e
+   thread) são criados uma vez por criarContextoIA(); cada decisão só acorda
+   as threads, que recopiam o mapa e buscam. */
+struct ContextoIA {
+    ConfigIA cfg;
+    int qtd;                /* tamanho do mapa das cópias */
+    int numThreads;
+    TrabalhadorIA *trab;
+    pthread_t *threads;
+    pthread_mutex_t trava;
+    pthread_cond_t inicio;  /* nova busca (ou encerrar) */
+    pthread_cond_t fim;     /* a última thread da busca terminou */
+    long long geracao;      /* buscas já iniciadas */
+    int pendentes;          /* threads ainda na busca atual */
+    int encerrar;
+};
+
+/* listarJogadasIA():
+   Candidatos de ataque de 'cor': pares (origem, destino) válidos pelas regras
+   de validarAtaque(), mantendo os 'max' de maior vantagem de tropas (desempate
+   pelo menor índice, então o resultado é determinístico). Sem grafo, cada
+   origem é pareada com o território inimigo mais fraco. Custo O(território + arestas).
+*/
+static int listarJogadasIA(const Mapa *mapa, int cor, int *origens, int *destinos, int max) {
+    const Grafo *g = mapa->grafo;
+    int vantagens[IA_MAX_JOGADAS];
+    int cont = 0, maisFraco = -1;
+    if (!g) {
+        for (int i = 0; i < mapa->qtd; ++i)
+            if (mapa->dono[i] != cor && (maisFraco < 0 || mapa->tropas[i] < mapa->tropas[maisFraco]))
+                maisFraco = i;
+        if (maisFraco < 0) return 0;
+    }
+    for (int i = 0; i < mapa->qtd; ++i) {
+        if (mapa->dono[i] != cor || mapa->tropas[i] < 2) continue;
+        int64_t e = g ? g->inicio[i] : 0, fim = g ? g->inicio[i + 1] : 1;
+        for (; e < fim; ++e) {
+            int d = g ? g->vizinhos[e] : maisFraco;
+            if (mapa->dono[d] == cor) continue;
+            int vantagem = mapa->tropas[i] - mapa->tropas[d];
+            if (cont == max && vantagem <= vantagens[max - 1]) continue;
+            int k = cont < max ? cont++ : max - 1;
+            while (k > 0 && vantagens[k - 1] < vantagem) {
+                vantagens[k] = vantagens[k - 1];
+                origens[k] = origens[k - 1];
+                destinos[k] = destinos[k - 1];
+                k--;
+            }
+            vantagens[k] = vantagem;
+            origens[k] = i;
+            destinos[k] = d;
+        }
+    }
+    return cont;
+}
+
+/* atacarIA():
+   Resolve um ataque com dados sorteados; o diário ligado ao mapa da thread
+   anota as mutações para o desfazer do fim do playout.
+*/
+static void atacarIA(TrabalhadorIA *t, int origem, int destino) {
+    int dadoAtk = rngDado(&t->rng);
+    int dadoDef = rngDado(&t->rng);
+    resolverBatalha(t->mapa, origem, destino, dadoAtk, dadoDef, NULL);
+}
+
+/* rodadaAleatoriaIA():
+   Um ataque aleatório de cada uma das 'vezes' cores seguintes a 'depoisDe'
+   que ainda estejam vivas (política padrão dos oponentes e dos rollouts).
+*/
+static void rodadaAleatoriaIA(TrabalhadorIA *t, int depoisDe, int vezes) {
+    Mapa *mapa = t->mapa;
+    for (int k = 1; k <= vezes; ++k) {
+        int c = (depoisDe + k) % mapa->numCores;
+        if (corEliminada(mapa, c)) continue;
+        int origem, destino;
+        if (escolherAtaqueAleatorio(mapa, c, &t->rng, &origem, &destino))
+            atacarIA(t, origem, destino);
+    }
+}
+
+/* avaliarIA():
+   Recompensa de um estado para 'cor' em [0, 1]: 0 se eliminada, 1 se dona de
+   tudo; senão a média entre a fração de territórios e a fração de tropas.
+*/
+static double avaliarIA(const Mapa *mapa, int cor) {
+    if (mapa->territoriosPorCor[cor] == 0) return 0.0;
+    if (mapa->territoriosPorCor[cor] == mapa->qtd) return 1.0;
+    long long tropasTotal = 0;
+    for (int c = 0; c < mapa->numCores; ++c) tropasTotal += mapa->tropasPorCor[c];
+    double fracTerritorios = (double) mapa->territoriosPorCor[cor] / (double) mapa->qtd;
+    double fracTropas = tropasTotal > 0 ? (double) mapa->tropasPorCor[cor] / (double) tropasTotal : 0.0;
+    return 0.5 * fracTerritorios + 0.5 * fracTropas;
+}
+
+/* expandirNoIA():
+   Cria os filhos de 'no' a partir dos candidatos no estado atual. Sem espaço
+   na arena o nó fica como folha.
+*/
+static void expandirNoIA(TrabalhadorIA *t, NoIA *no) {
+    int origens[IA_MAX_JOGADAS], destinos[IA_MAX_JOGADAS];
+    int n = listarJogadasIA(t->mapa, t->cor, origens, destinos, IA_MAX_JOGADAS);
+    no->expandido = 1;
+    no->filhos = n ? (NoIA*) arenaAlocar(&t->arena, (size_t) n * sizeof(NoIA)) : NULL;
+    if (!no->filhos) return;
+    memset(no->filhos, 0, (size_t) n * sizeof(NoIA));
+    for (int k = 0; k < n; ++k) {
+        no->filhos[k].origem = origens[k];
+        no->filhos[k].destino = destinos[k];
+    }
+    no->numFilhos = n;
+}
+
+/* selecionarFilhoIA():
+   UCB1 entre os filhos legais no estado atual; filhos nunca visitados têm
+   prioridade. Retorna NULL se nenhum for legal.
+*/
+static NoIA* selecionarFilhoIA(const TrabalhadorIA *t, const NoIA *no) {
+    NoIA *melhor = NULL;
+    double melhorValor = -1.0;
+    double logPai = log((double) no->visitas + 1.0);
+    for (int k = 0; k < no->numFilhos; ++k) {
+        NoIA *f = &no->filhos[k];
+        if (validarAtaque(t->mapa, f->origem, f->destino, t->cor) != ATAQUE_OK) continue;
+        if (f->visitas == 0) return f;
+        double valor = f->soma / f->visitas + IA_EXPLORACAO * sqrt(logPai / f->visitas);
+        if (valor > melhorValor) {
+            melhorValor = valor;
+            melhor = f;
+        }
+    }
+    return melhor;
+}
+
+/* executarTrabalhadorIA():
+   Uma busca de um trabalhador (paralelização na raiz): seleção/expansão descendo a
+   árvore — cada jogada da IA seguida de uma rodada aleatória dos oponentes —,
+   rollout de IA_RODADAS_ROLLOUT rodadas, retropropagação da recompensa e
+   desfazerAte() de volta à raiz. Para no prazo (conferido a cada 16 iterações) ou em
+   maxIteracoes.
+*/
+static void executarTrabalhadorIA(TrabalhadorIA *t) {
+    int numCores = t->mapa->numCores;
+    for (long long it = 0; ; ++it) {
+        if (t->maxIteracoes > 0 ? it >= t->maxIteracoes
+                                : (it > 0 && (it & 15) == 0 && segundosMonotonicos() >= t->prazo))
+            break;
+
+        NoIA *caminho[IA_PROFUNDIDADE + 1];
+        int prof = 0;
+        NoIA *no = &t->no;
+        caminho[prof++] = no;
+        while (prof <= IA_PROFUNDIDADE) {
+            if (!no->expandido) expandirNoIA(t, no);
+            NoIA *filho = selecionarFilhoIA(t, no);
+            if (!filho) break;
+            atacarIA(t, filho->origem, filho->destino);
+            rodadaAleatoriaIA(t, t->cor, numCores - 1);   /* só os oponentes respondem */
+            caminho[prof++] = filho;
+            no = filho;
+            if (filho->visitas == 0) break;
+        }
+
+        for (int r = 0; r < IA_RODADAS_ROLLOUT && !corEliminada(t->mapa, t->cor); ++r)
+            rodadaAleatoriaIA(t, (t->cor + numCores - 1) % numCores, numCores);
+
+        double recompensa = avaliarIA(t->mapa, t->cor);
+        for (int k = 0; k < prof; ++k) {
+            caminho[k]->visitas++;
+            caminho[k]->soma += recompensa;
+        }
+        desfazerAte(t->mapa, 0);
+        t->playouts++;
+    }
+}
+
+/* prepararTrabalhadorIA():
+   Início de uma busca: descarta a árvore anterior (a arena volta à marca
+   logo após o mapa) e recopia da raiz só os vetores quentes do mapa; nomes
+   não são usados na busca.
+*/
+static void prepararTrabalhadorIA(TrabalhadorIA *t) {
+    const Mapa *raiz = t->raiz;
+    arenaRestaurar(&t->arena, t->marca);
+    memset(&t->no, 0, sizeof(t->no));
+    t->playouts = 0;
+    memcpy(t->mapa->dono, raiz->dono, (size_t) raiz->qtd * sizeof(uint8_t));
+    memcpy(t->mapa->tropas, raiz->tropas, (size_t) raiz->qtd * sizeof(int));
+    t->mapa->numCores = raiz->numCores;
+    memcpy(t->mapa->cores, raiz->cores, sizeof(raiz->cores));
+    memcpy(t->mapa->territoriosPorCor, raiz->territoriosPorCor, sizeof(raiz->territoriosPorCor));
+    memcpy(t->mapa->tropasPorCor, raiz->tropasPorCor, sizeof(raiz->tropasPorCor));
+    t->mapa->grafo = raiz->grafo;
+    diarioUsarBuffer(&t->diario, t->registros, IA_MAX_DIARIO);
+    t->mapa->diario = &t->diario;
+}
+
+/* executarLacoIA():
+   Thread de um trabalhador da IA: dorme até escolherJogadaIA() iniciar uma
+   busca, faz a sua parte e avisa quando a última termina.
+*/
+static void* executarLacoIA(void *arg) {
+    TrabalhadorIA *t = (TrabalhadorIA*) arg;
+    ContextoIA *ia = t->ia;
+    long long vista = 0;
+    pthread_mutex_lock(&ia->trava);
+    for (;;) {
+        while (ia->geracao == vista && !ia->encerrar) pthread_cond_wait(&ia->inicio, &ia->trava);
+        if (ia->encerrar) break;
+        vista = ia->geracao;
+        pthread_mutex_unlock(&ia->trava);
+        prepararTrabalhadorIA(t);
+        executarTrabalhadorIA(t);
+        pthread_mutex_lock(&ia->trava);
+        if (--ia->pendentes == 0) pthread_cond_signal(&ia->fim);
+    }
+    pthread_mutex_unlock(&ia->trava);
+    return NULL;
+}
+
+/* criarContextoIA():
+   Prepara os oponentes de uma partida com mapas de mapa->qtd territórios:
+   uma arena (cópia do mapa + nós da árvore) e uma thread por trabalhador de
+   'cfg', reaproveitadas em todas as decisões. Um trabalhador cuja thread não
+   sobe faz a sua busca na thread que chama escolherJogadaIA().
+   Retorna NULL se faltar memória.
+*/
+ContextoIA* criarContextoIA(const Mapa *mapa, const ConfigIA *cfg) {
+    ContextoIA *ia = (ContextoIA*) calloc(1, sizeof(ContextoIA));
+    if (!ia) return NULL;
+    ia->cfg = *cfg;
+    ia->qtd = mapa->qtd;
+    ia->numThreads = cfg->threads > 0 ? cfg->threads : 1;
+    pthread_mutex_init(&ia->trava, NULL);
+    pthread_cond_init(&ia->inicio, NULL);
+    pthread_cond_init(&ia->fim, NULL);
+    ia->trab = (TrabalhadorIA*) calloc((size_t) ia->numThreads, sizeof(TrabalhadorIA));
+    ia->threads = (pthread_t*) calloc((size_t) ia->numThreads, sizeof(pthread_t));
+    if (!ia->trab || !ia->threads) {
+        destruirContextoIA(ia);
+        return NULL;
+    }
+
+    size_t tamanhoArena = tamanhoArenaPartida(mapa->qtd, 0) + IA_ARENA_NOS;
+    for (int k = 0; k < ia->numThreads; ++k) {
+        TrabalhadorIA *t = &ia->trab[k];
+        t->ia = ia;
+        if (arenaCriar(&t->arena, tamanhoArena) != 0 ||
+            !(t->mapa = alocarMapaArena(&t->arena, mapa->qtd, 0))) {
+            destruirContextoIA(ia);
+            return NULL;
+        }
+        t->marca = arenaMarca(&t->arena);
+    }
+
+    int semThread = 0;
+    for (int k = 0; k < ia->numThreads; ++k) {
+        ia->trab[k].emThread = pthread_create(&ia->threads[k], NULL, executarLacoIA, &ia->trab[k]) == 0;
+        semThread += !ia->trab[k].emThread;
+    }
+    if (semThread)
+        fprintf(stderr, "Aviso: %d thread(s) da IA não puderam ser criadas; suas buscas rodam na thread que decide a jogada.\n", semThread);
+    return ia;
+}
+
+/* destruirContextoIA():
+   Encerra as threads e libera as arenas de um contexto (aceita NULL).
+*/
+void destruirContextoIA(ContextoIA *ia) {
+    if (!ia) return;
+    pthread_mutex_lock(&ia->trava);
+    ia->encerrar = 1;
+    pthread_cond_broadcast(&ia->inicio);
+    pthread_mutex_unlock(&ia->trava);
+    for (int k = 0; ia->trab && k < ia->numThreads; ++k) {
+        if (ia->trab[k].emThread) pthread_join(ia->threads[k], NULL);
+        arenaDestruir(&ia->trab[k].arena);
+    }
+    pthread_mutex_destroy(&ia->trava);
+    pthread_cond_destroy(&ia->inicio);
+    pthread_cond_destroy(&ia->fim);
+    free(ia->trab);
+    free(ia->threads);
+    free(ia);
+}
+
+/* escolherJogadaIA():
+   Escolhe o ataque de 'cor' por MCTS dentro do orçamento do contexto. Cada
+   trabalhador busca em uma cópia privada do mapa com uma árvore própria; no
+   fim, as visitas dos filhos da raiz — idênticos em todos, pois a expansão
+   da raiz é determinística — são somadas e vence o mais visitado. Com
+   iteracoes > 0 o resultado depende só da semente. O tempo medido inclui a
+   cópia do mapa, mas não a criação das arenas e threads (feita uma vez).
+   Retorna 1 e preenche 'decisao' se houver jogada, 0 se não houver ataque
+   possível e -1 se o contexto foi criado para outro tamanho de mapa.
+*/
+int escolherJogadaIA(ContextoIA *ia, const Mapa *mapa, int cor, uint64_t semente, DecisaoIA *decisao) {
+    if (mapa->qtd != ia->qtd) return -1;
+    int numThreads = ia->numThreads;
+    TrabalhadorIA *trab = ia->trab;
+    int resultado = 0, comThread = 0;
+
+    double inicio = segundosMonotonicos();
+    for (int k = 0; k < numThreads; ++k) {
+        TrabalhadorIA *t = &trab[k];
+        t->raiz = mapa;
+        t->cor = cor;
+        t->prazo = inicio + ia->cfg.orcamento;
+        t->maxIteracoes = ia->cfg.iteracoes > 0 ? (ia->cfg.iteracoes + numThreads - 1) / numThreads : 0;
+        rngSemearFluxo(&t->rng, semente, (uint64_t) k);
+        comThread += t->emThread;
+    }
+
+    pthread_mutex_lock(&ia->trava);
+    ia->pendentes = comThread;
+    ia->geracao++;
+    pthread_cond_broadcast(&ia->inicio);
+    pthread_mutex_unlock(&ia->trava);
+    /* buscas sem thread rodam aqui; toda busca faz ao menos uma iteração,
+       então a raiz de cada uma fica expandida mesmo depois do prazo */
+    for (int k = 0; k < numThreads; ++k) {
+        if (trab[k].emThread) continue;
+        prepararTrabalhadorIA(&trab[k]);
+        executarTrabalhadorIA(&trab[k]);
+    }
+    pthread_mutex_lock(&ia->trava);
+    while (ia->pendentes > 0) pthread_cond_wait(&ia->fim, &ia->trava);
+    pthread_mutex_unlock(&ia->trava);
+
+    /* mescla as raízes: os filhos estão na mesma ordem em todas as threads */
+    const NoIA *raiz = &trab[0].no;
+    int melhor = -1;
+    long long melhorVisitas = -1;
+    double melhorSoma = 0.0;
+    decisao->playouts = 0;
+    for (int k = 0; k < numThreads; ++k) decisao->playouts += trab[k].playouts;
+    for (int f = 0; f < raiz->numFilhos; ++f) {
+        long long visitas = 0;
+        double soma = 0.0;
+        for (int k = 0; k < numThreads; ++k) {
+            if (f >= trab[k].no.numFilhos) continue;
+            visitas += trab[k].no.filhos[f].visitas;
+            soma += trab[k].no.filhos[f].soma;
+        }
+        if (visitas > melhorVisitas || (visitas == melhorVisitas && soma > melhorSoma)) {
+            melhor = f;
+            melhorVisitas = visitas;
+            melhorSoma = soma;
+        }
+    }
+    if (melhor >= 0) {
+        decisao->origem = raiz->filhos[melhor].origem;
+        decisao->destino = raiz->filhos[melhor].destino;
+        decisao->valor = melhorVisitas > 0 ? melhorSoma / (double) melhorVisitas : 0.0;
+        resultado = 1;
+    }
+    decisao->threads = numThreads;
+    decisao->segundos = segundosMonotonicos() - inicio;
+    return resultado;
+}
+
+/* executarTurnosIA():
+   Depois da jogada do jogador humano, cada outra cor ainda viva faz um
+   ataque escolhido por escolherJogadaIA() e executado com simularAtaque()
+   (mesma mensagem de um ataque humano), seguido do esforço da busca.
+*/
+void executarTurnosIA(Mapa *mapa, int corJogador, ContextoIA *ia, GeradorAleatorio *rng) {
+    for (int c = 0; c < mapa->numCores; ++c) {
+        if (c == corJogador || corEliminada(mapa, c)) continue;
+        printf("\n--- TURNO DA IA (%s) ---\n", mapa->cores[c]);
+        DecisaoIA decisao;
+        int r = escolherJogadaIA(ia, mapa, c, rngProximo(rng), &decisao);
+        if (r < 0) {
+            fprintf(stderr, "A IA foi preparada para outro mapa.\n");
+            return;
+        }
+        if (r == 0) {
+            printf("%s não tem ataques possíveis.\n", mapa->cores[c]);
+            continue;
+        }
+        simularAtaque(mapa, decisao.origem, decisao.destino, rng);
+        printf("(IA: %lld playouts em %.1f ms, %.0f playouts/s, %d thread(s), valor estimado %.3f)\n",
+               decisao.playouts, decisao.segundos * 1e3,
+               decisao.segundos > 0 ? (double) decisao.playouts / decisao.segundos : 0.0,
+               decisao.threads, decisao.valor);
+    }
+}
+
+/* executarBenchIA():
+   Modo não interativo: war --bench-ia [--territorios N] [--cores N] [--ms N]
+                        [--threads N] [--semente N] [--sem-fronteiras]
+   Mede quantos playouts por segundo a IA faz com 1..T threads dentro do
+   orçamento de --ms por jogada, para calibrar força contra latência (o
+   contexto de cada contagem de threads é criado fora da medida).
+*/
+int executarBenchIA(int argc, char *argv[]) {
+    int qtd = (int) lerOpcaoInteira(argc, argv, "--territorios", 42);
+    int numCores = (int) lerOpcaoInteira(argc, argv, "--cores", 2);
+    long long ms = lerOpcaoInteira(argc, argv, "--ms", 200);
+    int maxThreads = (int) lerOpcaoInteira(argc, argv, "--threads", sysconf(_SC_NPROCESSORS_ONLN));
+    GeradorAleatorio rng;
+    rngSemear(&rng, (uint64_t) lerOpcaoInteira(argc, argv, "--semente", 1));
+    char cores[MAX_CORES][TAM_COR] = { "Azul", "Vermelho", "Verde", "Amarelo", "Preto", "Branco" };
+
+    if (qtd < 2 || numCores < 2 || numCores > MAX_CORES || ms < 1 || maxThreads < 1) {
+        fprintf(stderr, "Uso: %s --bench-ia [--territorios N] [--cores 2..6] [--ms N] [--threads N] [--semente N] [--sem-fronteiras]\n", argv[0]);
+        return 1;
+    }
+
+    Mapa *mapa = alocarMapa(qtd, 0);
+    Grafo *grafo = temOpcao(argc, argv, "--sem-fronteiras") ? NULL : gerarGrafoGrade(qtd);
+    if (!mapa || (!grafo && !temOpcao(argc, argv, "--sem-fronteiras"))) {
+        fprintf(stderr, "Falha na alocação de memória para o mapa.\n");
+        liberarMemoria(mapa, NULL);
+        liberarGrafo(grafo);
+        return 1;
+    }
+    inicializarTerritorios(mapa, cores, numCores, &rng);
+    mapa->grafo = grafo;
+
+    printf("=== BENCH IA (%d territórios, %d cores, %lld ms por jogada) ===\n", qtd, numCores, ms);
+    printf("%-8s %-12s %-14s %-10s %s\n", "THREADS", "PLAYOUTS", "PLAYOUTS/s", "VALOR", "JOGADA");
+    for (int t = 1; t <= maxThreads; ++t) {
+        ConfigIA cfg = { (double) ms / 1e3, 0, t };
+        ContextoIA *ia = criarContextoIA(mapa, &cfg);
+        if (!ia) {
+            fprintf(stderr, "Falha na alocação de memória para a IA.\n");
+            break;
+        }
+        DecisaoIA decisao;
+        int r = escolherJogadaIA(ia, mapa, 0, rngProximo(&rng), &decisao);
+        destruirContextoIA(ia);
+        if (r == 0) {
+            printf("Nenhum ataque possível.\n");
+            break;
+        }
+        printf("%-8d %-12lld %-14.0f %-10.3f %d -> %d\n", t, decisao.playouts,
+               decisao.segundos > 0 ? (double) decisao.playouts / decisao.segundos : 0.0,
+               decisao.valor, decisao.origem, decisao.destino);
+    }
+
+    liberarMemoria(mapa, NULL);
+    liberarGrafo(grafo);
+    return 0;
+}
+
+/* iniciarTurnos():
+   Monta a rotação com as cores internadas que ainda têm territórios, na
+   ordem dos ids, começando pela cor humana (se houver e estiver viva).
+*/
+void iniciarTurnos(Turnos *t, const Mapa *mapa, int corHumana) {
+    memset(t, 0, sizeof(*t));
+    t->rodada = 1;
+    t->corHumana = corHumana;
+    for (int c = 0; c < MAX_CORES; ++c) t->ancora[c] = -1;
+    for (int c = 0; c < mapa->numCores; ++c) {
+        if (corEliminada(mapa, c)) continue;
+        if (c == corHumana) t->vez = t->numJogadores;
+        t->ordem[t->numJogadores++] = (uint8_t) c;
+    }
+}
+
+/* jogadorDaVez():
+   Cor do jogador da vez, ou COR_NENHUMA se a partida acabou (menos de 2 vivos).
+*/
+int jogadorDaVez(const Turnos *t) {
+    return t->numJogadores >= 2 ? t->ordem[t->vez] : COR_NENHUMA;
+}
+
+/* avancarTurno():
+   Encerra o turno do jogador da vez: tira da rotação as cores eliminadas
+   (consulta O(1) nos agregados, sem varrer o mapa), passa a vez ao próximo
+   vivo e conta a rodada quando a rotação recomeça. Em 'eliminadas' (se não
+   for NULL) devolve a máscara de bits das cores removidas agora.
+   Retorna a cor da vez ou COR_NENHUMA se a partida acabou.
+*/
+int avancarTurno(Turnos *t, const Mapa *mapa, int *eliminadas) {
+    int mascara = 0, vivos = 0, proxima = 0;
+    for (int k = 0; k < t->numJogadores; ++k) {
+        int cor = t->ordem[k];
+        if (k == t->vez) proxima = vivos + !corEliminada(mapa, cor);
+        if (corEliminada(mapa, cor)) {
+            mascara |= 1 << cor;
+            t->eliminadoNaRodada[cor] = t->rodada;
+        } else {
+            t->ordem[vivos++] = (uint8_t) cor;
+        }
+    }
+    t->numJogadores = vivos;
+    if (proxima >= vivos) {
+        proxima = 0;
+        t->rodada++;
+    }
+    t->vez = proxima;
+    if (eliminadas) *eliminadas = mascara;
+    return jogadorDaVez(t);
+}
+
+/* calcularReforco():
+   Tropas recebidas no início do turno: uma a cada REFORCO_DIVISOR territórios
+   da cor, com mínimo REFORCO_MINIMO. Lê o agregado: O(1).
+*/
+int calcularReforco(const Mapa *mapa, int cor) {
+    long long reforco = mapa->territoriosPorCor[cor] / REFORCO_DIVISOR;
+    return reforco < REFORCO_MINIMO ? REFORCO_MINIMO : (int) reforco;
+}
+
+/* reforcarTerritorio():
+   Soma 'tropas' ao território idx, que precisa ser da cor (passa por
+   atualizarTerritorio(), então agregados e diário continuam valendo).
+   Satura em INT32_MAX em vez de estourar em partidas muito longas.
+   Retorna 0 ou -1 se o território não for válido para a cor.
+*/
+int reforcarTerritorio(Mapa *mapa, int cor, int idx, int tropas) {
+    if (idx < 0 || idx >= mapa->qtd || mapa->dono[idx] != cor) return -1;
+    int atual = mapa->tropas[idx];
+    atualizarTerritorio(mapa, idx, cor, atual > INT32_MAX - tropas ? INT32_MAX : atual + tropas);
+    return 0;
+}
+
+/* territorioDeReforco():
+   Território da cor que recebe o reforço quando não há ataque a preparar: a
+   âncora do jogador, se ainda for dele; senão procura o próximo território
+   da cor a partir dela (só acontece depois que a âncora foi perdida) e a
+   atualiza. Retorna -1 se a cor não tem territórios.
+*/
+int territorioDeReforco(const Mapa *mapa, Turnos *t, int cor) {
+    int inicio = t->ancora[cor];
+    if (inicio >= 0 && inicio < mapa->qtd && mapa->dono[inicio] == cor) return inicio;
+    if (corEliminada(mapa, cor)) return -1;
+    if (inicio < 0 || inicio >= mapa->qtd) inicio = 0;
+    for (int k = 0; k < mapa->qtd; ++k) {
+        int i = inicio + k < mapa->qtd ? inicio + k : inicio + k - mapa->qtd;
+        if (mapa->dono[i] == cor) return t->ancora[cor] = i;
+    }
+    return -1;
+}
+
+/* faseDeReforco():
+   Interface do reforço do jogador humano: informa quantas tropas ele recebe
+   e pede o território que as recebe. Entrada inválida coloca o reforço no
+   território sugerido (o mesmo que um jogador automático usaria).
+*/
+void faseDeReforco(Mapa *mapa, Turnos *t, int cor) {
+    int reforco = calcularReforco(mapa, cor);
+    int idx = -1;
+    char buf[TAM_NOME];
+
+    printf("\n--- FASE DE REFORÇO (rodada %lld) ---\n", t->rodada);
+    printf("Você recebe %d tropas (%lld territórios / %d, mínimo %d).\n", reforco,
+           mapa->territoriosPorCor[cor], REFORCO_DIVISOR, REFORCO_MINIMO);
+    printf("Digite o índice do território que recebe o reforço: ");
+    if (scanf("%d", &idx) != 1) idx = -1;
+    limparBufferEntrada();
+
+    if (reforcarTerritorio(mapa, cor, idx, reforco) != 0) {
+        idx = territorioDeReforco(mapa, t, cor);
+        if (idx < 0) return;
+        printf("Território inválido; o reforço vai para %s.\n", nomeTerritorio(mapa, idx, buf, sizeof(buf)));
+        reforcarTerritorio(mapa, cor, idx, reforco);
+    }
+    t->ancora[cor] = idx;
+    printf("%s agora tem %d tropas.\n", nomeTerritorio(mapa, idx, buf, sizeof(buf)), mapa->tropas[idx]);
+}
+
+/* jogarTurnoAutomatico():
+   Turno completo de um jogador automático: escolhe o ataque (MCTS com o
+   contexto 'ia', ou o sorteio de escolherAtaqueAleatorio() sem ele), coloca o
+   reforço na origem escolhida — ou na âncora, se não houver ataque — e ataca.
+   Com 'verboso' imprime o turno como o jogo interativo (simularAtaque());
+   sem ele resolve em silêncio. Retorna 1 se atacou, 0 se não, -1 se a IA
+   não pôde decidir.
+*/
+int jogarTurnoAutomatico(Mapa *mapa, Turnos *t, int cor, ContextoIA *ia, GeradorAleatorio *rng, int verboso) {
+    int reforco = calcularReforco(mapa, cor);
+    int origem = -1, destino = -1, temAtaque;
+    DecisaoIA decisao;
+
+    if (ia) {
+        temAtaque = escolherJogadaIA(ia, mapa, cor, rngProximo(rng), &decisao);
+        if (temAtaque < 0) return -1;
+        origem = decisao.origem;
+        destino = decisao.destino;
+    } else {
+        temAtaque = escolherAtaqueAleatorio(mapa, cor, rng, &origem, &destino);
+    }
+
+    int alvo = temAtaque ? origem : territorioDeReforco(mapa, t, cor);
+    if (alvo < 0) return 0;
+    reforcarTerritorio(mapa, cor, alvo, reforco);
+    t->ancora[cor] = alvo;
+
+    if (verboso) {
+        char buf[TAM_NOME];
+        printf("\n--- TURNO DE %s (rodada %lld) ---\n", mapa->cores[cor], t->rodada);
+        printf("Reforço: +%d tropas em %s.\n", reforco, nomeTerritorio(mapa, alvo, buf, sizeof(buf)));
+    }
+    if (!temAtaque) {
+        if (verboso) printf("%s não tem ataques possíveis.\n", mapa->cores[cor]);
+        return 0;
+    }
+
+    if (verboso) {
+        simularAtaque(mapa, origem, destino, rng);
+        if (ia)
+            printf("(IA: %lld playouts em %.1f ms, %d thread(s), valor estimado %.3f)\n",
+                   decisao.playouts, decisao.segundos * 1e3, decisao.threads, decisao.valor);
+    } else {
+        int dadoAtk = rngDado(rng);
+        int dadoDef = rngDado(rng);
+        resolverBatalha(mapa, origem, destino, dadoAtk, dadoDef, NULL);
+    }
+    return 1;
+}
+
+/* executarTurnosAutomaticos():
+   Encerra o turno atual e joga os turnos automáticos seguintes até a vez
+   voltar à cor humana; com 'verboso', anuncia os turnos e cada eliminação.
+   Retorna a cor humana, ou COR_NENHUMA se a partida acabou (só restou um
+   jogador ou o humano foi eliminado).
+*/
+int executarTurnosAutomaticos(Mapa *mapa, Turnos *t, ContextoIA *ia, GeradorAleatorio *rng, int verboso) {
+    for (;;) {
+        int eliminadas;
+        int cor = avancarTurno(t, mapa, &eliminadas);
+        for (int c = 0; verboso && c < MAX_CORES; ++c)
+            if (eliminadas & (1 << c)) printf("\n*** %s foi eliminado na rodada %lld! ***\n", mapa->cores[c], t->eliminadoNaRodada[c]);
+
+        if (cor == COR_NENHUMA) return COR_NENHUMA;
+        if (t->corHumana != COR_NENHUMA && corEliminada(mapa, t->corHumana)) return COR_NENHUMA;
+        if (cor == t->corHumana) return cor;
+        if (jogarTurnoAutomatico(mapa, t, cor, ia, rng, verboso) < 0) {
+            fprintf(stderr, "A IA não pôde decidir; as demais jogadas são sorteadas.\n");
+            ia = NULL;
+        }
+    }
+}
+
+/* executarBenchTurnos():
+   Modo não interativo: war --bench-turnos [--territorios N] [--jogadores N]
+                        [--rodadas N] [--semente N] [--sem-fronteiras]
+   Partida só de jogadores automáticos (reforço + um ataque por turno) até
+   restar um jogador ou acabar o limite de rodadas. Imprime o custo por
+   rodada — que não deve crescer com o tamanho do mapa —, as eliminações e o
+   placar final lido dos agregados.
+*/
+int executarBenchTurnos(int argc, char *argv[]) {
+    int qtd = (int) lerOpcaoInteira(argc, argv, "--territorios", 42);
+    int numCores = (int) lerOpcaoInteira(argc, argv, "--jogadores", MAX_CORES);
+    long long maxRodadas = lerOpcaoInteira(argc, argv, "--rodadas", TURNOS_MAX_RODADAS);
+    GeradorAleatorio rng;
+    rngSemear(&rng, (uint64_t) lerOpcaoInteira(argc, argv, "--semente", 1));
+    char cores[MAX_CORES][TAM_COR] = { "Azul", "Vermelho", "Verde", "Amarelo", "Preto", "Branco" };
+
+    if (qtd < 2 || numCores < 2 || numCores > MAX_CORES || maxRodadas < 1) {
+        fprintf(stderr, "Uso: %s --bench-turnos [--territorios N] [--jogadores 2..6] [--rodadas N] [--semente N] [--sem-fronteiras]\n", argv[0]);
+        return 1;
+    }
+
+    Mapa *mapa = alocarMapa(qtd, 0);
+    Grafo *grafo = temOpcao(argc, argv, "--sem-fronteiras") ? NULL : gerarGrafoGrade(qtd);
+    if (!mapa || (!grafo && !temOpcao(argc, argv, "--sem-fronteiras"))) {
+        fprintf(stderr, "Falha na alocação de memória para o mapa.\n");
+        liberarMemoria(mapa, NULL);
+        liberarGrafo(grafo);
+        return 1;
+    }
+    inicializarTerritorios(mapa, cores, numCores, &rng);
+    mapa->grafo = grafo;
+    mapa->registrar = logAtivo();
+    registrarInicioPartida(mapa);
+
+    Turnos turnos;
+    iniciarTurnos(&turnos, mapa, COR_NENHUMA);
+    long long numTurnos = 0, ataques = 0;
+    double inicio = segundosMonotonicos();
+    for (int cor = jogadorDaVez(&turnos); cor != COR_NENHUMA && turnos.rodada <= maxRodadas;
+         cor = avancarTurno(&turnos, mapa, NULL)) {
+        ataques += jogarTurnoAutomatico(mapa, &turnos, cor, NULL, &rng, 0);
+        numTurnos++;
+    }
+    double decorrido = segundosMonotonicos() - inicio;
+    long long rodadas = turnos.rodada - (turnos.numJogadores >= 2);
+    if (turnos.numJogadores == 1) registrarVitoria(mapa, turnos.ordem[0], NULL);
+
+    printf("=== BENCH TURNOS (%d territórios, %d jogadores) ===\n", qtd, numCores);
+    printf("Rodadas: %lld | turnos: %lld | ataques: %lld em %.3f s\n", rodadas, numTurnos, ataques, decorrido);
+    printf("Custo: %.1f ns/turno, %.1f ns/rodada\n",
+           numTurnos ? decorrido * 1e9 / (double) numTurnos : 0.0,
+           rodadas ? decorrido * 1e9 / (double) rodadas : 0.0);
+    printf("%-10s %-14s %-16s %s\n", "COR", "TERRITÓRIOS", "TROPAS", "SITUAÇÃO");
+    for (int c = 0; c < mapa->numCores; ++c) {
+        char situacao[48];
+        if (turnos.eliminadoNaRodada[c])
+            snprintf(situacao, sizeof(situacao), "eliminado na rodada %lld", turnos.eliminadoNaRodada[c]);
+        else
+            snprintf(situacao, sizeof(situacao), "%s", turnos.numJogadores < 2 ? "vencedor" : "vivo");
+        printf("%-10s %-14lld %-16lld %s\n", mapa->cores[c], mapa->territoriosPorCor[c], mapa->tropasPorCor[c], situacao);
+    }
+
+    liberarMemoria(mapa, NULL);
+    liberarGrafo(grafo);
+    return 0;
+}
+
+/* medirDiario():
+   Corpo de executarBenchDiario() sobre buffers já alocados. Retorna 0 se o
+   desfazer e o replay conferem, 1 caso contrário.
+*/
+static int medirDiario(Mapa *mapa, Diario *diario, LanceReplay *lances, long long numAtaques,
+                       uint8_t *donoInicial, int *tropasInicial, uint8_t *donoFinal, int *tropasFinal,
+                       GeradorAleatorio *rng) {
+    size_t qtd = (size_t) mapa->qtd;
+    memcpy(donoInicial, mapa->dono, qtd * sizeof(uint8_t));
+    memcpy(tropasInicial, mapa->tropas, qtd * sizeof(int));
+    long long territoriosInicial = mapa->territoriosPorCor[0], tropasAzulInicial = mapa->tropasPorCor[0];
+
+    /* 1) partida com diário ligado, gravando os lances (até ninguém poder atacar) */
+    mapa->diario = diario;
+    long long jogados = 0;
+    double inicio = segundosMonotonicos();
+    int semAtaque = 0;  /* vezes seguidas sem ataque possível: 2 = nenhuma cor ataca mais */
+    for (long long a = 0; a < numAtaques && semAtaque < 2; ++a) {
+        int origem, destino;
+        if (!escolherAtaqueAleatorio(mapa, (int) (a & 1), rng, &origem, &destino)) { semAtaque++; continue; }
+        semAtaque = 0;
+        LanceReplay *l = &lances[jogados++];
+        l->origem = origem;
+        l->destino = destino;
+        l->dadoAtk = (uint8_t) rngDado(rng);
+        l->dadoDef = (uint8_t) rngDado(rng);
+        resolverBatalha(mapa, origem, destino, l->dadoAtk, l->dadoDef, NULL);
+    }
+    double tJogar = segundosMonotonicos() - inicio;
+    size_t registros = diario->qtd;
+    if (diario->incompleto) {
+        fprintf(stderr, "Falta de memória para o diário depois de %zu registros.\n", registros);
+        mapa->diario = NULL;
+        return 1;
+    }
+    memcpy(donoFinal, mapa->dono, qtd * sizeof(uint8_t));
+    memcpy(tropasFinal, mapa->tropas, qtd * sizeof(int));
+
+    /* 2) desfaz tudo e compara com o inicial */
+    inicio = segundosMonotonicos();
+    desfazerAte(mapa, 0);
+    double tDesfazer = segundosMonotonicos() - inicio;
+    int voltou = memcmp(mapa->dono, donoInicial, qtd) == 0 &&
+                 memcmp(mapa->tropas, tropasInicial, qtd * sizeof(int)) == 0 &&
+                 mapa->territoriosPorCor[0] == territoriosInicial && mapa->tropasPorCor[0] == tropasAzulInicial;
+
+    /* 3) replay por deltas: reaplica os lances sem diário */
+    mapa->diario = NULL;
+    inicio = segundosMonotonicos();
+    for (long long k = 0; k < jogados; ++k)
+        resolverBatalha(mapa, lances[k].origem, lances[k].destino, lances[k].dadoAtk, lances[k].dadoDef, NULL);
+    double tReplay = segundosMonotonicos() - inicio;
+    int reproduziu = memcmp(mapa->dono, donoFinal, qtd) == 0 &&
+                     memcmp(mapa->tropas, tropasFinal, qtd * sizeof(int)) == 0;
+
+    double porAtaque = jogados ? (double) jogados : 1.0;
+    double bytesSnapshots = (double) jogados * (double) qtd * (sizeof(uint8_t) + sizeof(int));
+    double bytesReplay = (double) jogados * sizeof(LanceReplay);
+    double bytesDiario = (double) registros * sizeof(RegistroDiario);
+    printf("=== DIÁRIO DE JOGADAS (%zu territórios, %lld ataques) ===\n", qtd, jogados);
+    printf("Jogar com diário: %.3f s (%.1f ns/ataque) | %zu registros\n", tJogar, tJogar * 1e9 / porAtaque, registros);
+    printf("Desfazer tudo:    %.3f ms (%.1f ns/ataque) | estado inicial %s\n",
+           tDesfazer * 1e3, tDesfazer * 1e9 / porAtaque, voltou ? "confere" : "DIVERGENTE");
+    printf("Replay (deltas):  %.3f ms | estado final %s\n", tReplay * 1e3, reproduziu ? "confere" : "DIVERGENTE");
+    printf("Memória: replay %.2f MB | diário %.2f MB | um snapshot por ataque %.2f MB (%.0fx)\n",
+           bytesReplay / 1e6, bytesDiario / 1e6, bytesSnapshots / 1e6,
+           bytesReplay > 0 ? bytesSnapshots / bytesReplay : 0.0);
+    return !(voltou && reproduziu);
+}
+
+/* executarBenchDiario():
+   Modo não interativo: war --bench-diario [--territorios N] [--ataques N] [--semente N]
+   Joga até N ataques automáticos (cores alternadas) com o diário ligado e
+   gravando o replay como lances. Depois confere que:
+   - desfazerAte(0) devolve exatamente o mapa inicial;
+   - reaplicar os lances sobre o mapa inicial reproduz o mapa final.
+   Imprime o tempo por ataque desfeito e a memória do replay por deltas
+   contra guardar um snapshot do mapa a cada ataque.
+*/
+int executarBenchDiario(int argc, char *argv[]) {
+    int qtd = (int) lerOpcaoInteira(argc, argv, "--territorios", 100000);
+    long long numAtaques = lerOpcaoInteira(argc, argv, "--ataques", 100000);
+    uint64_t semente = (uint64_t) lerOpcaoInteira(argc, argv, "--semente", 1);
+    char cores[MAX_CORES][TAM_COR] = { "Azul", "Vermelho" };
+
+    if (qtd < 2 || numAtaques < 1) {
+        fprintf(stderr, "Uso: %s --bench-diario [--territorios N] [--ataques N] [--semente N]\n", argv[0]);
+        return 1;
+    }
+
+    GeradorAleatorio rng;
+    rngSemear(&rng, semente);
+    Mapa *mapa = alocarMapa(qtd, 0);
+    Grafo *grafo = gerarGrafoGrade(qtd);
+    uint8_t *donoInicial = (uint8_t*) memAlocar((size_t) qtd * sizeof(uint8_t));
+    int *tropasInicial = (int*) memAlocar((size_t) qtd * sizeof(int));
+    uint8_t *donoFinal = (uint8_t*) memAlocar((size_t) qtd * sizeof(uint8_t));
+    int *tropasFinal = (int*) memAlocar((size_t) qtd * sizeof(int));
+    LanceReplay *lances = (LanceReplay*) memAlocar((size_t) numAtaques * sizeof(LanceReplay));
+    Diario diario;
+    int erro = diarioCriar(&diario, 1024) != 0;
+    if (!mapa || !grafo || !donoInicial || !tropasInicial || !donoFinal || !tropasFinal || !lances || erro) {
+        fprintf(stderr, "Falha na alocação de memória para o bench do diário.\n");
+        erro = 1;
+    } else {
+        inicializarTerritorios(mapa, cores, 2, &rng);
+        mapa->grafo = grafo;
+        erro = medirDiario(mapa, &diario, lances, numAtaques, donoInicial, tropasInicial,
+                           donoFinal, tropasFinal, &rng);
+    }
+
+    diarioLiberar(&diario);
+    free(lances);
+    free(donoInicial);
+    free(tropasInicial);
+    free(donoFinal);
+    free(tropasFinal);
+    liberarMemoria(mapa, NULL);
+    liberarGrafo(grafo);
+    return erro;
+}
+
+/* lerArquivoInteiro():
+   Lê o arquivo (ou o stdin, se caminho for "-") inteiro para um buffer do
+   heap terminado em '\0'. Arquivos regulares saem em uma única read() do
+   tamanho de fstat(); pipes crescem o buffer dobrando. Retorna o buffer (e o
+   tamanho em *tam) ou NULL em caso de erro (com mensagem).
+*/
+static char* lerArquivoInteiro(const char *caminho, size_t *tam) {
+    int fd = strcmp(caminho, "-") == 0 ? STDIN_FILENO : open(caminho, O_RDONLY);
+    if (fd < 0) {
+        perror(caminho);
+        return NULL;
+    }
+    struct stat st;
+    size_t capacidade = (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) ? (size_t) st.st_size + 1 : 1 << 16;
+    char *buf = (char*) memAlocar(capacidade);
+    size_t usado = 0;
+    while (buf) {
+        if (usado + 1 == capacidade) {
+            char *novo = (char*) realloc(buf, capacidade * 2);
+            if (!novo) { free(buf); buf = NULL; break; }
+            buf = novo;
+            capacidade *= 2;
+        }
+        ssize_t n = read(fd, buf + usado, capacidade - 1 - usado);
+        if (n < 0) {
+            perror(caminho);
+            free(buf);
+            buf = NULL;
+        } else if (n == 0) {
+            break;
+        } else {
+            usado += (size_t) n;
+        }
+    }
+    if (fd != STDIN_FILENO) close(fd);
+    if (!buf) return NULL;
+    buf[usado] = '\0';
+    *tam = usado;
+    return buf;
+}
+
+/* Fatia de texto dentro do buffer do roteiro (sem cópia nem '\0') */
+typedef struct {
+    const char *p;
+    int tam;
+} Palavra;
+
+/* proximaPalavra():
+   Avança *cursor até o fim da próxima palavra da linha (para em '\n').
+   Retorna 1 e preenche 'w', ou 0 se a linha acabou.
+*/
+static int proximaPalavra(const char **cursor, const char *fim, Palavra *w) {
+    const char *c = *cursor;
+    while (c < fim && (*c == ' ' || *c == '\t' || *c == '\r')) c++;
+    if (c == fim || *c == '\n' || *c == '#') {
+        *cursor = c;
+        return 0;
+    }
+    w->p = c;
+    while (c < fim && *c != ' ' && *c != '\t' && *c != '\r' && *c != '\n') c++;
+    w->tam = (int) (c - w->p);
+    *cursor = c;
+    return 1;
+}
+
+/* palavraIgual():
+   Compara uma palavra com um literal sem copiar.
+*/
+static int palavraIgual(const Palavra *w, const char *literal) {
+    size_t n = strlen(literal);
+    return (size_t) w->tam == n && memcmp(w->p, literal, n) == 0;
+}
+
+/* palavraInteira():
+   Converte a palavra em int (sinal opcional, só dígitos, sem estouro).
+   Retorna 1 e preenche *valor, ou 0 se não for um inteiro válido.
+*/
+static int palavraInteira(const Palavra *w, int *valor) {
+    int k = 0, negativo = 0;
+    long long v = 0;
+    if (w->tam > 0 && (w->p[0] == '-' || w->p[0] == '+')) negativo = w->p[k++] == '-';
+    if (k == w->tam) return 0;
+    for (; k < w->tam; ++k) {
+        if (w->p[k] < '0' || w->p[k] > '9') return 0;
+        v = v * 10 + (w->p[k] - '0');
+        if (v > INT32_MAX) return 0;
+    }
+    *valor = (int) (negativo ? -v : v);
+    return 1;
+}
+
+/* reforcoDoRoteiro():
+   Reforço do turno do jogador no modo de comandos: vai para 'idx' ou, se
+   ele não for da cor, para o território sugerido. Retorna o território
+   reforçado, ou -1 se a cor não tem territórios.
+*/
+static int reforcoDoRoteiro(Mapa *mapa, Turnos *t, int cor, int idx, int eco) {
+    int reforco = calcularReforco(mapa, cor);
+    if (reforcarTerritorio(mapa, cor, idx, reforco) != 0) {
+        idx = territorioDeReforco(mapa, t, cor);
+        if (idx < 0) return -1;
+        reforcarTerritorio(mapa, cor, idx, reforco);
+    }
+    t->ancora[cor] = idx;
+    if (eco) {
+        char buf[TAM_NOME];
+        printf("\nReforço (rodada %lld): +%d tropas em %s.\n", t->rodada, reforco, nomeTerritorio(mapa, idx, buf, sizeof(buf)));
+    }
+    return idx;
+}
+
+/* executarComandos():
+   Modo não interativo: war --comandos ARQ|- [--territorios N] [--semente N] [--eco] [--ia ...]
+   Lê o roteiro inteiro de uma vez e executa um comando por linha, sem menu,
+   sem scanf e sem pausas:
+     attack O D  (ou atacar O D)   -> ataque como a opção 1 do menu
+     reinforce I (ou reforcar I)   -> reforço do turno em I (só com 'turnos')
+     check       (ou verificar)    -> verificação como a opção 2
+     map         (ou mapa)         -> imprime o mapa
+     quit        (ou sair)         -> encerra o roteiro
+   Linhas vazias e comentários (#) são ignorados. Os ataques passam por
+   executarAtaqueJogador() e consomem o gerador na mesma ordem do jogo
+   interativo, então a mesma semente e os mesmos lances dão o mesmo jogo.
+   Com 'turnos' (--jogadores) cada ataque fecha um turno completo: o reforço
+   vai para o território do reforce anterior ou, sem ele, para a origem do
+   ataque, e depois as demais cores jogam; o roteiro termina quando a
+   partida acaba. Com --eco imprime as mensagens do jogo interativo; sem
+   ele, só um resumo.
+   Retorna 0, ou 1 se o roteiro não pôde ser lido ou teve linhas inválidas.
+*/
+int executarComandos(const char *caminho, Mapa *mapa, const Missao *missao, int corJogador,
+                     Turnos *turnos, GeradorAleatorio *rng, ContextoIA *ia, int eco) {
+    size_t tam;
+    char *texto = lerArquivoInteiro(caminho, &tam);
+    if (!texto) return 1;
+
+    long long comandos = 0, ataques = 0, recusados = 0, conquistas = 0, verificacoes = 0;
+    long long linhasInvalidas = 0, cumpridaEm = 0;
+    const char *cursor = texto, *fim = texto + tam;
+    int sair = 0, reforcado = 0, partidaEncerrada = 0;
+    double inicio = segundosMonotonicos();
+    for (long long linha = 1; cursor < fim && !sair; ++linha) {
+        Palavra cmd, a, b, extra;
+        if (proximaPalavra(&cursor, fim, &cmd)) {
+            int origem, destino;
+            comandos++;
+            if (palavraIgual(&cmd, "attack") || palavraIgual(&cmd, "atacar")) {
+                if (proximaPalavra(&cursor, fim, &a) && proximaPalavra(&cursor, fim, &b) &&
+                    palavraInteira(&a, &origem) && palavraInteira(&b, &destino) &&
+                    !proximaPalavra(&cursor, fim, &extra)) {
+                    ataques++;
+                    if (turnos && !reforcado) reforcoDoRoteiro(mapa, turnos, corJogador, origem, eco);
+                    int codigo = executarAtaqueJogador(mapa, corJogador, origem, destino, rng, eco);
+                    if (codigo != ATAQUE_OK) recusados++;
+                    else conquistas += mapa->dono[destino] == corJogador;
+                    if (turnos) {
+                        reforcado = 0;
+                        if (executarTurnosAutomaticos(mapa, turnos, ia, rng, eco) == COR_NENHUMA)
+                            sair = partidaEncerrada = 1;
+                    } else if (ia) {
+                        executarTurnosIA(mapa, corJogador, ia, rng);
+                    }
+                } else {
+                    fprintf(stderr, "Linha %lld: uso: attack ORIGEM DESTINO\n", linha);
+                    linhasInvalidas++;
+                }
+            } else if (palavraIgual(&cmd, "reinforce") || palavraIgual(&cmd, "reforcar")) {
+                if (!turnos) {
+                    fprintf(stderr, "Linha %lld: reinforce só vale com --jogadores\n", linha);
+                    linhasInvalidas++;
+                } else if (reforcado) {
+                    fprintf(stderr, "Linha %lld: o reforço deste turno já foi colocado\n", linha);
+                    linhasInvalidas++;
+                } else if (proximaPalavra(&cursor, fim, &a) && palavraInteira(&a, &origem) &&
+                           !proximaPalavra(&cursor, fim, &extra)) {
+                    reforcoDoRoteiro(mapa, turnos, corJogador, origem, eco);
+                    reforcado = 1;
+                } else {
+                    fprintf(stderr, "Linha %lld: uso: reinforce TERRITORIO\n", linha);
+                    linhasInvalidas++;
+                }
+            } else if (palavraIgual(&cmd, "check") || palavraIgual(&cmd, "verificar")) {
+                int cumprida = verificarVitoria(mapa, missao, corJogador);
+                verificacoes++;
+                if (cumprida && !cumpridaEm) {
+                    cumpridaEm = comandos;
+                    registrarVitoria(mapa, corJogador, missao);
+                }
+                if (eco) exibirVerificacao(cumprida);
+            } else if (palavraIgual(&cmd, "map") || palavraIgual(&cmd, "mapa")) {
+                exibirMapa(mapa);
+            } else if (palavraIgual(&cmd, "quit") || palavraIgual(&cmd, "sair")) {
+                sair = 1;
+            } else {
+                fprintf(stderr, "Linha %lld: comando desconhecido '%.*s'\n", linha, cmd.tam, cmd.p);
+                linhasInvalidas++;
+            }
+        }
+        /* descarta o resto da linha (inclusive argumentos inválidos) */
+        while (cursor < fim && *cursor != '\n') cursor++;
+        if (cursor < fim) cursor++;
+    }
+    double decorrido = segundosMonotonicos() - inicio;
+    free(texto);
+
+    printf("\n=== ROTEIRO DE COMANDOS ===\n");
+    printf("Comandos: %lld em %.3f s (%.2f milhões/s)\n", comandos, decorrido,
+           decorrido > 0 ? (double) comandos / decorrido / 1e6 : 0.0);
+    printf("Ataques: %lld (recusados %lld, conquistas %lld) | verificações: %lld | linhas inválidas: %lld\n",
+           ataques, recusados, conquistas, verificacoes, linhasInvalidas);
+    printf("Sua cor: %s | territórios: %lld | tropas: %lld\n", mapa->cores[corJogador],
+           mapa->territoriosPorCor[corJogador], mapa->tropasPorCor[corJogador]);
+    if (turnos) {
+        printf("Rodada %lld | jogadores na partida: %d\n", turnos->rodada, turnos->numJogadores);
+        if (partidaEncerrada && corEliminada(mapa, corJogador)) {
+            printf("Você foi eliminado na rodada %lld.\n", turnos->eliminadoNaRodada[corJogador]);
+        } else if (partidaEncerrada) {
+            printf("Todos os adversários foram eliminados. Você venceu!\n");
+            registrarVitoria(mapa, corJogador, NULL);
+        }
+    }
+    if (cumpridaEm)
+        printf("Missão cumprida na verificação do comando #%lld.\n", cumpridaEm);
+    else
+        printf("Missão %s.\n", verificarVitoria(mapa, missao, corJogador) ? "cumprida (não verificada no roteiro)" : "não cumprida");
+    return linhasInvalidas ? 1 : 0;
+}
+
+/* ================================ MISSÕES ================================
+   As missões são dados: cada linha de um arquivo de regras (--missoes ARQ)
+   descreve uma regra, e a tabela padrão embutida usa o mesmo formato.
+
+     nome  CONDIÇÃO [e CONDIÇÃO ...] : descrição
+
+   CONDIÇÃO é "territorios|tropas [outra] >=|<= QUANTIDADE" ou
+   "eliminar outra" (o mesmo que "territorios outra <= 0"); sem "outra" a
+   condição vale para a cor do jogador, com "outra" para uma cor alvo
+   sorteada entre as demais. QUANTIDADE é uma soma (com " + ") de parcelas
+   N, mapa, mapa/D, M*mapa ou M*mapa/D (mapa = número de territórios), e
+   "sorteio Q" soma um inteiro uniforme em [0, Q]. Na descrição, {1}..{4}
+   são as quantidades de cada condição e {cor} o nome da cor alvo.
+
+   compilarMissoes() valida e transforma o texto em modelos de termos uma
+   única vez; sortearMissao() instancia um modelo em um programa plano de
+   termos sobre os agregados, e verificarVitoria() só o executa. */
+
+static const char missoesPadrao[] =
+    "# regra     objetivo                             : descrição\n"
+    "conquistar  territorios >= mapa/3 + sorteio 2    : Conquistar {1} territorios.\n"
+    "destruir    eliminar outra                       : Eliminar a cor {cor} do mapa.\n"
+    "reunir      tropas >= mapa + sorteio mapa/2      : Reunir ao menos {1} tropas no total.\n";
+
+static TabelaMissoes tabelaPadrao;
+static TabelaMissoes tabelaCarregada;
+static const TabelaMissoes *tabelaAtiva = NULL;
+static pthread_once_t tabelaPadraoOnce = PTHREAD_ONCE_INIT;
+
+/* palavraQuantidade():
+   Converte uma parcela (N, mapa, mapa/D, M*mapa ou M*mapa/D).
+   Retorna 1 e preenche 'p', ou 0 se a palavra não for uma parcela.
+*/
+static int palavraQuantidade(const Palavra *w, ParcelaMissao *p) {
+    p->multiplicador = 0;
+    p->divisor = 1;
+    p->constante = 0;
+    if (palavraInteira(w, &p->constante)) return p->constante >= 0;
+
+    const char *c = w->p, *fim = w->p + w->tam;
+    long long mult = 1, div = 1;
+    if (c < fim && *c >= '0' && *c <= '9') {
+        for (mult = 0; c < fim && *c >= '0' && *c <= '9' && mult <= INT32_MAX; ++c) mult = mult * 10 + (*c - '0');
+        if (c == fim || *c++ != '*') return 0;
+    }
+    if (fim - c < 4 || memcmp(c, "mapa", 4) != 0) return 0;
+    c += 4;
+    if (c < fim) {
+        if (*c++ != '/' || c == fim) return 0;
+        for (div = 0; c < fim && *c >= '0' && *c <= '9' && div <= INT32_MAX; ++c) div = div * 10 + (*c - '0');
+        if (c != fim) return 0;
+    }
+    if (mult > INT32_MAX || div < 1 || div > INT32_MAX) return 0;
+    p->multiplicador = (int) mult;
+    p->divisor = (int) div;
+    return 1;
+}
+
+/* validarDescricao():
+   Confere os marcadores do modelo de descrição: {1}..{numTermos} e, se a
+   regra tiver cor alvo, {cor}. Retorna NULL ou a mensagem de erro.
+*/
+static const char* validarDescricao(const RegraMissao *r) {
+    int temAlvo = 0;
+    for (int k = 0; k < r->numTermos; ++k) temAlvo |= r->termos[k].alvo == MISSAO_ALVO_OUTRA;
+    for (const char *c = strchr(r->descricao, '{'); c; c = strchr(c + 1, '{')) {
+        if (c[1] >= '1' && c[1] < '1' + r->numTermos && c[2] == '}') continue;
+        if (strncmp(c, "{cor}", 5) == 0) {
+            if (!temAlvo) return "{cor} sem condição sobre \"outra\"";
+            continue;
+        }
+        return "marcador inválido na descrição (use {1}..{N} ou {cor})";
+    }
+    return NULL;
+}
+
+/* compilarMissoes():
+   Compila o texto de regras (formato acima) em 'tabela'. Linhas vazias e
+   comentários (#) são ignorados. Os erros saem em stderr como
+   "origem:linha: mensagem". Retorna 0, ou -1 se houve erro ou nenhuma regra.
+*/
+int compilarMissoes(const char *texto, size_t tam, const char *origem, TabelaMissoes *tabela) {
+    memset(tabela, 0, sizeof(*tabela));
+    const char *cursor = texto, *fim = texto + tam;
+    int erros = 0;
+    for (int linha = 1; cursor < fim; ++linha) {
+        Palavra nome, w;
+        const char *erro = NULL;
+        if (proximaPalavra(&cursor, fim, &nome)) {
+            RegraMissao *r = NULL;
+            if (tabela->numRegras == MISSAO_MAX_REGRAS) {
+                erro = "regras demais";
+            } else {
+                r = &tabela->regras[tabela->numRegras];
+                memset(r, 0, sizeof(*r));
+                if ((size_t) nome.tam >= sizeof(r->nome)) erro = "nome de regra longo demais";
+                else memcpy(r->nome, nome.p, (size_t) nome.tam);
+            }
+
+            /* condições, separadas por "e" e terminadas por ":" */
+            int fimCondicoes = 0;
+            while (!erro && !fimCondicoes) {
+                if (r->numTermos == MISSAO_MAX_TERMOS) { erro = "condições demais"; break; }
+                ModeloTermo *t = &r->termos[r->numTermos];
+                if (!proximaPalavra(&cursor, fim, &w)) { erro = "esperava uma condição"; break; }
+                if (palavraIgual(&w, "eliminar")) {
+                    if (!proximaPalavra(&cursor, fim, &w) || !palavraIgual(&w, "outra")) {
+                        erro = "uso: eliminar outra";
+                        break;
+                    }
+                    t->campo = MISSAO_CAMPO_TERRITORIOS;
+                    t->alvo = MISSAO_ALVO_OUTRA;
+                    t->sinal = -1;
+                    t->numParcelas = 1;
+                    t->parcelas[0].divisor = 1;
+                    if (!proximaPalavra(&cursor, fim, &w)) w.tam = 0;
+                } else {
+                    if (palavraIgual(&w, "territorios")) t->campo = MISSAO_CAMPO_TERRITORIOS;
+                    else if (palavraIgual(&w, "tropas")) t->campo = MISSAO_CAMPO_TROPAS;
+                    else { erro = "condição desconhecida (territorios, tropas ou eliminar)"; break; }
+                    int temPalavra = proximaPalavra(&cursor, fim, &w);
+                    if (temPalavra && palavraIgual(&w, "outra")) {
+                        t->alvo = MISSAO_ALVO_OUTRA;
+                        temPalavra = proximaPalavra(&cursor, fim, &w);
+                    }
+                    if (temPalavra && palavraIgual(&w, ">=")) t->sinal = 1;
+                    else if (temPalavra && palavraIgual(&w, "<=")) t->sinal = -1;
+                    else { erro = "esperava >= ou <="; break; }
+
+                    /* quantidade: parcelas separadas por "+" */
+                    int maisParcelas = 1;
+                    while (maisParcelas) {
+                        if (t->numParcelas == MISSAO_MAX_PARCELAS) { erro = "parcelas demais"; break; }
+                        ParcelaMissao *p = &t->parcelas[t->numParcelas++];
+                        if (!proximaPalavra(&cursor, fim, &w)) { erro = "esperava uma quantidade"; break; }
+                        if (palavraIgual(&w, "sorteio")) {
+                            p->sorteio = 1;
+                            if (!proximaPalavra(&cursor, fim, &w)) { erro = "esperava a quantidade do sorteio"; break; }
+                        }
+                        if (!palavraQuantidade(&w, p)) { erro = "quantidade inválida"; break; }
+                        if (!proximaPalavra(&cursor, fim, &w)) w.tam = 0;
+                        maisParcelas = palavraIgual(&w, "+");
+                    }
+                    if (erro) break;
+                }
+                r->numTermos++;
+                if (palavraIgual(&w, ":")) fimCondicoes = 1;
+                else if (!palavraIgual(&w, "e")) erro = "esperava \"e\" ou \":\" depois da condição";
+            }
+
+            /* descrição: o resto da linha, sem os espaços das pontas */
+            if (!erro) {
+                while (cursor < fim && (*cursor == ' ' || *cursor == '\t')) cursor++;
+                const char *ini = cursor;
+                while (cursor < fim && *cursor != '\n') cursor++;
+                const char *ult = cursor;
+                while (ult > ini && (ult[-1] == ' ' || ult[-1] == '\t' || ult[-1] == '\r')) ult--;
+                if (ult == ini) erro = "falta a descrição";
+                else if ((size_t) (ult - ini) >= sizeof(r->descricao)) erro = "descrição longa demais";
+                else {
+                    memcpy(r->descricao, ini, (size_t) (ult - ini));
+                    erro = validarDescricao(r);
+                }
+            }
+            if (erro) {
+                fprintf(stderr, "%s:%d: %s\n", origem, linha, erro);
+                erros++;
+            } else {
+                tabela->numRegras++;
+            }
+        }
+        while (cursor < fim && *cursor != '\n') cursor++;
+        if (cursor < fim) cursor++;
+    }
+    if (!erros && tabela->numRegras == 0) {
+        fprintf(stderr, "%s: nenhuma regra de missão\n", origem);
+        erros++;
+    }
+    return erros ? -1 : 0;
+}
+
+static void compilarTabelaPadrao(void) {
+    if (compilarMissoes(missoesPadrao, sizeof(missoesPadrao) - 1, "missões padrão", &tabelaPadrao) != 0)
+        abort();
+}
+
+/* tabelaMissoes():
+   Tabela de missões em uso por sortearMissao(): a carregada por
+   carregarMissoes() ou, sem ela, a padrão (compilada no primeiro uso).
+*/
+const TabelaMissoes* tabelaMissoes(void) {
+    if (tabelaAtiva) return tabelaAtiva;
+    pthread_once(&tabelaPadraoOnce, compilarTabelaPadrao);
+    return &tabelaPadrao;
+}
+
+/* carregarMissoes():
+   Lê e compila o arquivo de regras e passa a usá-lo nos sorteios seguintes.
+   Deve ser chamada antes de iniciar threads que sorteiam missões.
+   Retorna 0, ou -1 (com mensagem) mantendo a tabela anterior.
+*/
+int carregarMissoes(const char *caminho) {
+    size_t tam;
+    char *texto = lerArquivoInteiro(caminho, &tam);
+    if (!texto) return -1;
+    int r = compilarMissoes(texto, tam, caminho, &tabelaCarregada);
+    free(texto);
+    if (r == 0) tabelaAtiva = &tabelaCarregada;
+    return r;
+}
+
+/* executarBenchMissoes():
+   Modo não interativo: war --bench-missoes [--territorios N] [--quantidade N] [--rodadas N] [--semente N]
+   Sorteia N missões (da tabela ativa) para cores aleatórias de um mapa de 6
+   cores e mede verificarMissoes() sobre todas elas, como a checagem de fim
+   de turno de milhares de jogadores. Para conferir, as primeiras missões
+   também são avaliadas a partir de varreduras completas do mapa (varrerMapa).
+*/
+int executarBenchMissoes(int argc, char *argv[]) {
+    int qtdTerritorios = (int) lerOpcaoInteira(argc, argv, "--territorios", 1000000);
+    int quantidade = (int) lerOpcaoInteira(argc, argv, "--quantidade", 10000);
+    long long rodadas = lerOpcaoInteira(argc, argv, "--rodadas", 1000);
+    uint64_t semente = (uint64_t) lerOpcaoInteira(argc, argv, "--semente", 1);
+    if (qtdTerritorios < 1 || quantidade < 1 || rodadas < 1) {
+        fprintf(stderr, "Uso: %s --bench-missoes [--territorios N] [--quantidade N] [--rodadas N] [--semente N]\n", argv[0]);
+        return 1;
+    }
+
+    char cores[MAX_CORES][TAM_COR] = { "Azul", "Vermelho", "Verde", "Amarelo", "Preto", "Branco" };
+    GeradorAleatorio rng;
+    rngSemear(&rng, semente);
+    Mapa *mapa = alocarMapa(qtdTerritorios, 0);
+    Missao *missoes = (Missao*) memAlocar((size_t) quantidade * sizeof(Missao));
+    uint8_t *donos = (uint8_t*) memAlocar((size_t) quantidade);
+    uint8_t *cumpridas = (uint8_t*) memAlocar((size_t) quantidade);
+    Arena arena;
+    if (arenaCriar(&arena, 4096) != 0 || !mapa || !missoes || !donos || !cumpridas) {
+        fprintf(stderr, "Falha na alocação de memória para o benchmark de missões.\n");
+        arenaDestruir(&arena);
+        liberarMemoria(mapa, NULL);
+        free(missoes);
+        free(donos);
+        free(cumpridas);
+        return 1;
+    }
+    inicializarTerritorios(mapa, cores, MAX_CORES, &rng);
+    /* as duas últimas cores passam para a primeira: há missões cumpridas e cores eliminadas */
+    for (int i = 0; i < mapa->qtd; ++i)
+        if (mapa->dono[i] >= MAX_CORES - 2) atualizarTerritorio(mapa, i, 0, mapa->tropas[i]);
+
+    const TabelaMissoes *tabela = tabelaMissoes();
+    long long porRegra[MISSAO_MAX_REGRAS] = { 0 };
+    for (int k = 0; k < quantidade; ++k) {
+        donos[k] = (uint8_t) rngIntervalo(&rng, (uint32_t) mapa->numCores);
+        Missao *m = sortearMissao(mapa, donos[k], &rng, &arena);
+        if (!m) {
+            fprintf(stderr, "Falha ao sortear a missão %d da tabela ativa.\n", k);
+            arenaDestruir(&arena);
+            liberarMemoria(mapa, NULL);
+            free(missoes);
+            free(donos);
+            free(cumpridas);
+            return 1;
+        }
+        missoes[k] = *m;
+        porRegra[m->tipo]++;
+        arenaReiniciar(&arena);
+    }
+    arenaDestruir(&arena);
+
+    int cumpridasTotal = 0;
+    double inicio = segundosMonotonicos();
+    for (long long r = 0; r < rodadas; ++r)
+        cumpridasTotal = verificarMissoes(mapa, missoes, donos, quantidade, cumpridas);
+    double decorrido = segundosMonotonicos() - inicio;
+
+    /* referência: cada termo das primeiras missões por varredura completa */
+    int conferidas = quantidade < 64 ? quantidade : 64, divergentes = 0;
+    double inicioVarredura = segundosMonotonicos();
+    for (int k = 0; k < conferidas; ++k) {
+        int cumprida = 1;
+        for (int j = 0; j < missoes[k].numTermos; ++j) {
+            const TermoMissao *t = &missoes[k].termos[j];
+            VarreduraCor v;
+            varrerMapa(mapa, t->cor == MISSAO_COR_JOGADOR ? donos[k] : t->cor, COR_NENHUMA, &v);
+            long long valor = t->campo == MISSAO_CAMPO_TROPAS ? v.tropas : v.territorios;
+            cumprida &= t->sinal * valor >= t->limiar;
+        }
+        divergentes += cumprida != cumpridas[k];
+    }
+    double tempoVarredura = (segundosMonotonicos() - inicioVarredura) / conferidas;
+
+    printf("=== MISSÕES (%d missões, %d territórios, %d regras) ===\n", quantidade, qtdTerritorios, tabela->numRegras);
+    for (int k = 0; k < tabela->numRegras; ++k)
+        printf("  %-16s %lld sorteadas\n", tabela->regras[k].nome, porRegra[k]);
+    printf("Verificação de todas: %.2f us (%.2f ns/missão) | cumpridas: %d\n",
+           decorrido / (double) rodadas * 1e6, decorrido / (double) rodadas / quantidade * 1e9, cumpridasTotal);
+    printf("Por varredura do mapa: %.3f ms/missão (%d conferidas, %d divergente(s))\n",
+           tempoVarredura * 1e3, conferidas, divergentes);
+
+    liberarMemoria(mapa, NULL);
+    free(missoes);
+    free(donos);
+    free(cumpridas);
+    return divergentes ? 1 : 0;
+}
+
+/* ============================ LOG DE EVENTOS ============================
+   Log binário de batalhas, conquistas, missões e vitórias (--log ARQ).
+   Cada thread escreve num anel próprio, sem travas (devolvido para reuso
+   quando a thread termina, então threads de vida curta como as dos lotes
+   de ataques não acumulam anéis); uma thread gravadora
+   esvazia os anéis a cada LOG_INTERVALO_MS (ou quando um anel passa da
+   metade) com uma writev() por anel. O jogo nunca espera pelo disco: com o
+   anel cheio o evento é descartado e contado (LOG_DESCARTE no fechamento).
+   Só mapas com 'registrar' ligado geram eventos de batalha, então os
+   playouts da IA e os benchmarks não poluem o log. */
+
+/* Anel de eventos de uma thread: um produtor (a thread) e um consumidor (o
+   gravador). 'escrito' só avança no produtor e 'lido' só no gravador. Um
+   anel 'livre' (a thread dona terminou) pode ser tomado por outra thread:
+   o id gravado nos blocos é o do anel, não o da thread. */
+typedef struct AnelLog {
+    EventoLog *eventos;                 /* LOG_ANEL_EVENTOS posições */
+    _Atomic uint64_t escrito;
+    _Atomic uint64_t lido;
+    _Atomic uint64_t perdidos;
+    _Atomic int livre;
+    uint32_t thread;
+    struct AnelLog *proximo;            /* lista imutável depois da inserção */
+} AnelLog;
+
+static _Atomic int logLigado;
+static int logArquivo = -1;
+static pthread_t logGravador;
+static pthread_mutex_t logTrava = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t logSinal = PTHREAD_COND_INITIALIZER;
+static int logParar;
+static int logFalhou;
+static _Atomic(AnelLog*) logAneis;
+static uint32_t logNumAneis;
+static pthread_key_t logChaveAnel;      /* destrutor devolve o anel da thread que termina */
+static _Thread_local AnelLog *logAnelLocal;
+static _Thread_local uint32_t logPartidaAtual;
+
+/* logDevolverAnel():
+   Destrutor da chave: marca o anel da thread que terminou como livre. Os
+   eventos que ele ainda tiver continuam na fila do gravador.
+*/
+static void logDevolverAnel(void *arg) {
+    atomic_store_explicit(&((AnelLog*) arg)->livre, 1, memory_order_release);
+}
+
+/* logAnel():
+   Anel da thread atual no primeiro evento: um anel livre da lista, se houver,
+   ou um novo, publicado na lista (NULL se faltar memória: os eventos da
+   thread são ignorados).
+*/
+static AnelLog* logAnel(void) {
+    if (logAnelLocal) return logAnelLocal;
+    for (AnelLog *livre = atomic_load_explicit(&logAneis, memory_order_acquire); livre; livre = livre->proximo) {
+        int esperado = 1;
+        if (atomic_compare_exchange_strong_explicit(&livre->livre, &esperado, 0,
+                                                    memory_order_acquire, memory_order_relaxed)) {
+            pthread_setspecific(logChaveAnel, livre);
+            return logAnelLocal = livre;
+        }
+    }
+    AnelLog *anel = (AnelLog*) calloc(1, sizeof(AnelLog));
+    if (!anel) return NULL;
+    anel->eventos = (EventoLog*) malloc(LOG_ANEL_EVENTOS * sizeof(EventoLog));
+    if (!anel->eventos) {
+        free(anel);
+        return NULL;
+    }
+    pthread_mutex_lock(&logTrava);
+    anel->thread = logNumAneis++;
+    anel->proximo = atomic_load_explicit(&logAneis, memory_order_relaxed);
+    atomic_store_explicit(&logAneis, anel, memory_order_release);
+    pthread_mutex_unlock(&logTrava);
+    pthread_setspecific(logChaveAnel, anel);
+    return logAnelLocal = anel;
+}
+
+/* descarregarAneis():
+   Grava o conteúdo pendente de cada anel como um bloco (cabeçalho + até
+   dois trechos, se o anel deu a volta) e libera as posições gravadas.
+   Só o gravador (ou logFechar(), depois dele) chama esta função.
+*/
+static void descarregarAneis(void) {
+    for (AnelLog *anel = atomic_load_explicit(&logAneis, memory_order_acquire); anel; anel = anel->proximo) {
+        uint64_t lido = atomic_load_explicit(&anel->lido, memory_order_relaxed);
+        uint64_t escrito = atomic_load_explicit(&anel->escrito, memory_order_acquire);
+        if (escrito == lido) continue;
+
+        BlocoLog bloco = { anel->thread, (uint32_t) (escrito - lido) };
+        size_t ini = (size_t) (lido & (LOG_ANEL_EVENTOS - 1));
+        size_t primeiro = LOG_ANEL_EVENTOS - ini < bloco.qtd ? LOG_ANEL_EVENTOS - ini : bloco.qtd;
+        struct iovec iov[3] = {
+            { &bloco, sizeof(bloco) },
+            { anel->eventos + ini, primeiro * sizeof(EventoLog) },
+            { anel->eventos, (bloco.qtd - primeiro) * sizeof(EventoLog) }
+        };
+        if (!logFalhou && escreverVetores(logArquivo, iov, bloco.qtd > primeiro ? 3 : 2) != 0) {
+            perror("Falha ao gravar o log de eventos");
+            logFalhou = 1;
+        }
+        atomic_store_explicit(&anel->lido, escrito, memory_order_release);
+    }
+}
+
+/* executarGravadorLog():
+   Thread gravadora: acorda a cada LOG_INTERVALO_MS (ou quando sinalizada)
+   e descarrega os anéis, até logFechar() pedir para parar.
+*/
+static void* executarGravadorLog(void *arg) {
+    (void) arg;
+    pthread_mutex_lock(&logTrava);
+    while (!logParar) {
+        struct timespec prazo;
+        clock_gettime(CLOCK_REALTIME, &prazo);
+        prazo.tv_nsec += LOG_INTERVALO_MS * 1000000L;
+        if (prazo.tv_nsec >= 1000000000L) {
+            prazo.tv_sec++;
+            prazo.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&logSinal, &logTrava, &prazo);
+        pthread_mutex_unlock(&logTrava);
+        descarregarAneis();
+        pthread_mutex_lock(&logTrava);
+    }
+    pthread_mutex_unlock(&logTrava);
+    return NULL;
+}
+
+/* logAbrir():
+   Cria o arquivo de log, grava o cabeçalho e inicia o gravador. O log é
+   fechado por logFechar(), também registrada com atexit().
+   Retorna 0 ou -1 em caso de erro (com mensagem).
+*/
+int logAbrir(const char *caminho) {
+    logArquivo = open(caminho, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (logArquivo < 0) {
+        perror("Falha ao criar o log de eventos");
+        return -1;
+    }
+    CabecalhoLog cab;
+    memset(&cab, 0, sizeof(cab));
+    memcpy(cab.magica, LOG_MAGICA, sizeof(LOG_MAGICA));
+    cab.versao = LOG_VERSAO;
+    cab.tamEvento = sizeof(EventoLog);
+    struct iovec iov = { &cab, sizeof(cab) };
+    if (escreverVetores(logArquivo, &iov, 1) != 0 ||
+        pthread_key_create(&logChaveAnel, logDevolverAnel) != 0) {
+        perror("Falha ao iniciar o log de eventos");
+        close(logArquivo);
+        logArquivo = -1;
+        return -1;
+    }
+    if (pthread_create(&logGravador, NULL, executarGravadorLog, NULL) != 0) {
+        perror("Falha ao iniciar o log de eventos");
+        pthread_key_delete(logChaveAnel);
+        close(logArquivo);
+        logArquivo = -1;
+        return -1;
+    }
+    atomic_store(&logLigado, 1);
+    atexit(logFechar);
+    return 0;
+}
+
+/* logFechar():
+   Para o gravador, descarrega o que restou, anota os descartes de cada
+   anel e fecha o arquivo. Deve ser chamada depois que as threads que geram
+   eventos terminaram; chamadas repetidas não fazem nada.
+*/
+void logFechar(void) {
+    if (!atomic_exchange(&logLigado, 0)) return;
+    pthread_mutex_lock(&logTrava);
+    logParar = 1;
+    pthread_cond_signal(&logSinal);
+    pthread_mutex_unlock(&logTrava);
+    pthread_join(logGravador, NULL);
+    pthread_key_delete(logChaveAnel);
+
+    /* o gravador pode ter parado antes dos últimos eventos: esvazia os anéis
+       para que o registro de descarte tenha onde entrar */
+    descarregarAneis();
+    uint64_t perdidos = 0;
+    for (AnelLog *anel = atomic_load(&logAneis); anel; anel = anel->proximo) {
+        uint64_t p = atomic_load(&anel->perdidos);
+        perdidos += p;
+        if (p) {
+            /* o anel acabou de ser esvaziado, então há espaço para o registro */
+            uint64_t w = atomic_load(&anel->escrito);
+            anel->eventos[w & (LOG_ANEL_EVENTOS - 1)] = (EventoLog) {
+                LOG_DESCARTE, COR_NENHUMA, COR_NENHUMA, 0, 0,
+                (int32_t) (p & INT32_MAX), (int32_t) (p >> 31)
+            };
+            atomic_store(&anel->escrito, w + 1);
+        }
+    }
+    descarregarAneis();
+    if (perdidos)
+        fprintf(stderr, "Log de eventos: %llu evento(s) descartado(s) com o anel cheio.\n", (unsigned long long) perdidos);
+
+    for (AnelLog *anel = atomic_load(&logAneis), *prox; anel; anel = prox) {
+        prox = anel->proximo;
+        free(anel->eventos);
+        free(anel);
+    }
+    atomic_store(&logAneis, NULL);
+    logAnelLocal = NULL;
+    if (close(logArquivo) != 0) perror("Falha ao fechar o log de eventos");
+    logArquivo = -1;
+}
+
+/* logAtivo():
+   Retorna 1 se há um log aberto (os modos ligam 'registrar' nos seus mapas).
+*/
+int logAtivo(void) {
+    return atomic_load_explicit(&logLigado, memory_order_relaxed);
+}
+
+/* logPartida():
+   Define a partida dos próximos eventos desta thread.
+*/
+void logPartida(uint32_t partida) {
+    logPartidaAtual = partida;
+}
+
+/* logEvento():
+   Acrescenta um evento ao anel da thread atual. Não trava e não faz E/S:
+   com o anel cheio descarta o evento; ao passar da metade acorda o gravador.
+*/
+void logEvento(int tipo, int cor, int outraCor, int detalhe, int32_t a, int32_t b) {
+    if (!logAtivo()) return;
+    AnelLog *anel = logAnel();
+    if (!anel) return;
+    uint64_t escrito = atomic_load_explicit(&anel->escrito, memory_order_relaxed);
+    uint64_t ocupado = escrito - atomic_load_explicit(&anel->lido, memory_order_acquire);
+    if (ocupado >= LOG_ANEL_EVENTOS) {
+        atomic_fetch_add_explicit(&anel->perdidos, 1, memory_order_relaxed);
+        return;
+    }
+    anel->eventos[escrito & (LOG_ANEL_EVENTOS - 1)] = (EventoLog) {
+        (uint8_t) tipo, (uint8_t) cor, (uint8_t) outraCor, (uint8_t) detalhe, logPartidaAtual, a, b
+    };
+    atomic_store_explicit(&anel->escrito, escrito + 1, memory_order_release);
+    if (ocupado == LOG_ANEL_EVENTOS / 2) pthread_cond_signal(&logSinal);
+}
+
+/* registrarInicioPartida() / registrarMissao() / registrarVitoria():
+   Eventos de partida para mapas com 'registrar' ligado (nada nos demais).
+   Vitória sem missão (missao == NULL) é a do último jogador restante.
+*/
+void registrarInicioPartida(const Mapa *mapa) {
+    if (mapa->registrar) logEvento(LOG_PARTIDA, COR_NENHUMA, COR_NENHUMA, 0, mapa->qtd, mapa->numCores);
+}
+
+void registrarMissao(const Mapa *mapa, int cor, const Missao *missao) {
+    if (mapa->registrar)
+        logEvento(LOG_MISSAO, cor, missao->alvoCor, missao->tipo, missao->alvoNumero, 0);
+}
+
+void registrarVitoria(const Mapa *mapa, int cor, const Missao *missao) {
+    if (mapa->registrar)
+        logEvento(LOG_VITORIA, cor, COR_NENHUMA, missao ? missao->tipo : LOG_SEM_MISSAO,
+                  (int32_t) mapa->territoriosPorCor[cor], (int32_t) (mapa->tropasPorCor[cor] > INT32_MAX ? INT32_MAX : mapa->tropasPorCor[cor]));
+}
+
+/* ============================ INSTRUMENTAÇÃO ============================
+   Só compilada com -DWAR_INSTRUMENTAR. Cada thread acumula, sem travas, em
+   um bloco próprio (criado no primeiro uso e encadeado numa lista global):
+   ciclos e chamadas por fase (inclusivos: simularAtaque contém
+   resolverBatalha), histogramas log2 e um buffer de eventos para o trace.
+   Só as fases "grossas" entram no trace; validar/resolver são só contadas.
+   O relatório e o trace saem no fim do processo (atexit), com --instr e
+   --trace ARQ. */
+#ifdef WAR_INSTRUMENTAR
+
+typedef struct {
+    uint64_t inicio;
+    uint64_t duracao;
+    uint8_t fase;
+} EventoTrace;
+
+typedef struct InstrThread {
+    uint64_t ciclos[NUM_FASES];
+    uint64_t chamadas[NUM_FASES];
+    uint64_t hist[NUM_HISTOGRAMAS][INSTR_BALDES];
+    EventoTrace *eventos;
+    uint32_t numEventos;
+    uint64_t descartados;
+    int tid;
+    struct InstrThread *proximo;
+} InstrThread;
+
+static const char *nomesFases[NUM_FASES] = {
+    "faseDeAtaque", "simularAtaque", "validarAtaque", "resolverBatalha",
+    "verificarVitoria", "renderizarMapa", "partida"
+};
+static const int faseRastreada[NUM_FASES] = { 1, 1, 0, 0, 1, 1, 1 };
+static const char *nomesHistogramas[NUM_HISTOGRAMAS] = {
+    "batalhas por partida", "conquistas por partida", "tropas transferidas por conquista"
+};
+
+static _Thread_local InstrThread *instrLocal;
+static InstrThread *instrLista;
+static int instrNumThreads;
+static pthread_mutex_t instrTrava = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t instrBaseOnce = PTHREAD_ONCE_INIT;
+static uint64_t instrBaseCiclos;
+static double instrBaseSegundos;
+static int instrComRelatorio;
+static const char *instrCaminhoTrace;
+
+/* instrRelogio():
+   Contador de ciclos (rdtsc) em x86; nos demais, nanossegundos monotônicos.
+*/
+uint64_t instrRelogio(void) {
+#ifdef WAR_X86
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+#endif
+}
+
+/* marca o par (ciclos, segundos) de referência para converter o trace em µs */
+static void instrFixarBase(void) {
+    instrBaseCiclos = instrRelogio();
+    instrBaseSegundos = segundosMonotonicos();
+}
+
+/* instrThread():
+   Bloco da thread atual, criado e registrado no primeiro uso (NULL se faltar memória).
+*/
+static InstrThread* instrThread(void) {
+    if (instrLocal) return instrLocal;
+    pthread_once(&instrBaseOnce, instrFixarBase);
+    InstrThread *t = (InstrThread*) calloc(1, sizeof(InstrThread));
+    if (!t) return NULL;
+    t->eventos = (EventoTrace*) malloc(INSTR_MAX_EVENTOS * sizeof(EventoTrace));
+    pthread_mutex_lock(&instrTrava);
+    t->tid = instrNumThreads++;
+    t->proximo = instrLista;
+    instrLista = t;
+    pthread_mutex_unlock(&instrTrava);
+    instrLocal = t;
+    return t;
+}
+
+/* instrFecharEscopo():
+   Chamada pelo atributo cleanup de INSTR_ESCOPO: soma a duração à fase e,
+   se a fase é rastreada, grava o evento (ou conta como descartado).
+*/
+void instrFecharEscopo(EscopoInstr *escopo) {
+    uint64_t fim = instrRelogio();
+    InstrThread *t = instrThread();
+    if (!t) return;
+    uint64_t duracao = fim - escopo->inicio;
+    t->ciclos[escopo->fase] += duracao;
+    t->chamadas[escopo->fase]++;
+    if (!faseRastreada[escopo->fase]) return;
+    if (t->eventos && t->numEventos < INSTR_MAX_EVENTOS)
+        t->eventos[t->numEventos++] = (EventoTrace) { escopo->inicio, duracao, (uint8_t) escopo->fase };
+    else
+        t->descartados++;
+}
+
+/* instrHistograma():
+   Soma 1 ao balde log2 de 'valor' no histograma 'hist' da thread atual.
+*/
+void instrHistograma(int hist, uint64_t valor) {
+    InstrThread *t = instrThread();
+    if (!t) return;
+    int balde = valor ? 64 - __builtin_clzll(valor) : 0;
+    t->hist[hist][balde < INSTR_BALDES ? balde : INSTR_BALDES - 1]++;
+}
+
+/* instrAoSair():
+   Handler de atexit: imprime o relatório (--instr) e grava o trace (--trace).
+*/
+static void instrAoSair(void) {
+    if (instrComRelatorio) instrRelatorio(stderr);
+    if (instrCaminhoTrace && instrSalvarTrace(instrCaminhoTrace) == 0)
+        fprintf(stderr, "Trace gravado em %s (abrir em chrome://tracing ou ui.perfetto.dev).\n", instrCaminhoTrace);
+}
+
+/* instrConfigurar():
+   Lê --instr e --trace ARQ e agenda a saída para o fim do processo.
+*/
+void instrConfigurar(int argc, char *argv[]) {
+    pthread_once(&instrBaseOnce, instrFixarBase);
+    instrComRelatorio = temOpcao(argc, argv, "--instr");
+    instrCaminhoTrace = lerOpcaoTexto(argc, argv, "--trace", NULL);
+    if (instrComRelatorio || instrCaminhoTrace) atexit(instrAoSair);
+}
+
+/* instrRelatorio():
+   Soma os blocos de todas as threads e imprime, por fase, chamadas, ciclos
+   totais, ciclos por chamada e por partida; depois os histogramas não vazios.
+*/
+void instrRelatorio(FILE *saida) {
+    uint64_t ciclos[NUM_FASES] = { 0 }, chamadas[NUM_FASES] = { 0 };
+    uint64_t hist[NUM_HISTOGRAMAS][INSTR_BALDES] = { { 0 } };
+    uint64_t eventos = 0, descartados = 0;
+    pthread_mutex_lock(&instrTrava);
+    for (const InstrThread *t = instrLista; t; t = t->proximo) {
+        for (int f = 0; f < NUM_FASES; ++f) {
+            ciclos[f] += t->ciclos[f];
+            chamadas[f] += t->chamadas[f];
+        }
+        for (int h = 0; h < NUM_HISTOGRAMAS; ++h)
+            for (int b = 0; b < INSTR_BALDES; ++b) hist[h][b] += t->hist[h][b];
+        eventos += t->numEventos;
+        descartados += t->descartados;
+    }
+    int numThreads = instrNumThreads;
+    pthread_mutex_unlock(&instrTrava);
+
+    uint64_t partidas = chamadas[FASE_PARTIDA];
+    fprintf(saida, "\n=== INSTRUMENTAÇÃO (%d thread(s), %llu partida(s)) ===\n",
+            numThreads, (unsigned long long) partidas);
+    fprintf(saida, "%-18s %-12s %-16s %-14s %-14s\n", "FASE", "CHAMADAS", "CICLOS", "CICLOS/CHAM.", "CICLOS/PARTIDA");
+    for (int f = 0; f < NUM_FASES; ++f) {
+        if (!chamadas[f]) continue;
+        fprintf(saida, "%-18s %-12llu %-16llu %-14.1f %-14.1f\n", nomesFases[f],
+                (unsigned long long) chamadas[f], (unsigned long long) ciclos[f],
+                (double) ciclos[f] / (double) chamadas[f],
+                partidas ? (double) ciclos[f] / (double) partidas : 0.0);
+    }
+    for (int h = 0; h < NUM_HISTOGRAMAS; ++h) {
+        uint64_t total = 0;
+        for (int b = 0; b < INSTR_BALDES; ++b) total += hist[h][b];
+        if (!total) continue;
+        fprintf(saida, "\nHistograma: %s (%llu amostras)\n", nomesHistogramas[h], (unsigned long long) total);
+        for (int b = 0; b < INSTR_BALDES; ++b) {
+            if (!hist[h][b]) continue;
+            unsigned long long de = b ? 1ULL << (b - 1) : 0, ate = b ? (1ULL << b) - 1 : 0;
+            fprintf(saida, "  %8llu..%-8llu %12llu  %5.1f%%\n", de, ate,
+                    (unsigned long long) hist[h][b], 100.0 * (double) hist[h][b] / (double) total);
+        }
+    }
+    fprintf(saida, "\nEventos de trace: %llu (descartados: %llu)\n",
+            (unsigned long long) eventos, (unsigned long long) descartados);
+}
+
+/* instrSalvarTrace():
+   Grava os eventos de todas as threads no formato JSON do Chrome trace
+   ("ph":"X", tempos em µs desde o início), com o nome de cada thread.
+   Retorna 0 ou -1 em caso de erro (com mensagem).
+*/
+int instrSalvarTrace(const char *caminho) {
+    FILE *f = fopen(caminho, "w");
+    if (!f) {
+        perror("Falha ao criar o trace");
+        return -1;
+    }
+    /* ciclos por µs, calibrados entre a base e agora */
+    double segundos = segundosMonotonicos() - instrBaseSegundos;
+    double ciclosPorUs = segundos > 0 ? (double) (instrRelogio() - instrBaseCiclos) / (segundos * 1e6) : 1.0;
+    if (ciclosPorUs <= 0) ciclosPorUs = 1.0;
+
+    fprintf(f, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n");
+    int primeiro = 1;
+    pthread_mutex_lock(&instrTrava);
+    for (const InstrThread *t = instrLista; t; t = t->proximo) {
+        fprintf(f, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": \"thread %d\"}}",
+                primeiro ? "" : ",\n", t->tid, t->tid);
+        primeiro = 0;
+        for (uint32_t k = 0; k < t->numEventos; ++k) {
+            const EventoTrace *e = &t->eventos[k];
+            fprintf(f, ",\n{\"name\": \"%s\", \"cat\": \"war\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f}",
+                    nomesFases[e->fase], t->tid,
+                    (double) (e->inicio - instrBaseCiclos) / ciclosPorUs, (double) e->duracao / ciclosPorUs);
+        }
+    }
+    pthread_mutex_unlock(&instrTrava);
+    fprintf(f, "\n]}\n");
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+#endif /* WAR_INSTRUMENTAR */
+
+/* limparBufferEntrada():
+   Função utilitária para limpar o buffer de entrada do teclado (stdin),
+   evitando problemas com leituras consecutivas de scanf e getchar.
+*/
+void limparBufferEntrada(void) {
+    int c;
+    while ((c = getchar()) != '\n' && c != EOF) { /* descarta */ }
+}
+
+/* segundosMonotonicos():
+   Relógio monotônico em segundos, usado para medir a vazão das simulações.
+*/
+double segundosMonotonicos(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+/* lerOpcaoInteira():
+   Procura "nome valor" em argv e devolve o valor inteiro; 'padrao' se ausente.
+*/
+long long lerOpcaoInteira(int argc, char *argv[], const char *nome, long long padrao) {
+    for (int i = 1; i + 1 < argc; ++i)
+        if (strcmp(argv[i], nome) == 0) return atoll(argv[i + 1]);
+    return padrao;
+}
+
+/* lerOpcaoTexto():
+   Procura "nome valor" em argv e devolve o texto do valor; 'padrao' se ausente.
+*/
+const char* lerOpcaoTexto(int argc, char *argv[], const char *nome, const char *padrao) {
+    for (int i = 1; i + 1 < argc; ++i)
+        if (strcmp(argv[i], nome) == 0) return argv[i + 1];
+    return padrao;
+}
+
+/* temOpcao():
+   Retorna 1 se a opção 'nome' aparece em argv.
+*/
+int temOpcao(int argc, char *argv[], const char *nome) {
+    for (int i = 1; i < argc; ++i)
+        if (strcmp(argv[i], nome) == 0) return 1;
+    return 0;
+}
@@ -0,0 +1,644 @@
+/*
+   war.h - declarações do núcleo do PROJETO WAR ESTRUTURADO: constantes,
+   tipos (mapa, grafo, arena, diário, missão...) e protótipos das funções
+   implementadas em nucleo.c (biblioteca libwar.a), usadas pelo jogo (war.c)
+   e pelo benchmark (bench.c).
+*/
+#ifndef WAR_H
+#define WAR_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <locale.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define WAR_X86 1
+#endif
+
+/* --- Constantes Globais --- */
+#define TAM_NOME 30
+#define TAM_COR 10
+#define MAX_CORES 6
+#define COR_NENHUMA 0xFF   /* id de cor inválido (território sem dono) */
+
+/* Tipos de missão: índices das regras da tabela padrão de missões */
+#define MISSao_CONQUISTAR_N 0
+#define MISSao_DESTRUIR_COR 1
+#define MISSao_REUNIR_TROPAS 2
+
+/* Missões como dados: regras lidas de um arquivo (--missoes ARQ) e
+   compiladas em termos sobre os agregados do mapa */
+#define MISSAO_MAX_REGRAS 32
+#define MISSAO_MAX_TERMOS 4
+#define MISSAO_MAX_PARCELAS 4
+#define MISSAO_CAMPO_TERRITORIOS 0
+#define MISSAO_CAMPO_TROPAS 1
+#define MISSAO_ALVO_JOGADOR 0
+#define MISSAO_ALVO_OUTRA 1
+#define MISSAO_COR_JOGADOR 0xFE   /* termo sobre a cor de quem verifica a missão */
+
+/* Resultado da validação de um ataque (validarAtaque) */
+#define ATAQUE_OK 0
+#define ATAQUE_FORA_DA_FAIXA 1
+#define ATAQUE_MESMO_TERRITORIO 2
+#define ATAQUE_ORIGEM_ALHEIA 3
+#define ATAQUE_MESMA_COR 4
+#define ATAQUE_TROPAS_INSUFICIENTES 5
+#define ATAQUE_NAO_VIZINHO 6
+
+/* Tabela de desfechos de sequências de ataque: pré-calculada para atacantes
+   com 2..TAB_BATALHA_MAX tropas; acima disso usa-se a forma fechada */
+#define TAB_BATALHA_MAX 128
+#define TAB_BATALHA_ENTRADAS (TAB_BATALHA_MAX * (TAB_BATALHA_MAX + 1) / 2)
+
+/* Snapshot binário do jogo (arquivo .war) */
+#define SNAPSHOT_MAGICA "WARSNAP"
+#define SNAPSHOT_VERSAO 3
+#define SNAPSHOT_TEM_NOMES  0x1u
+#define SNAPSHOT_TEM_GRAFO  0x2u
+#define SNAPSHOT_TEM_MISSAO 0x4u
+#define SNAPSHOT_ALINHAMENTO 64
+
+/* Renderização do mapa (exibirMapa / renderizarMapa) */
+#define EXIBIR_COMPLETO   0     /* todos os territórios */
+#define EXIBIR_ALTERACOES 1     /* só os territórios alterados desde o último quadro */
+#define EXIBIR_RESUMO     2     /* totais por cor + uma página de territórios */
+#define EXIBIR_LIMITE_COMPLETO 1000     /* acima disso o modo inicial é o resumo */
+#define EXIBIR_POR_PAGINA 20
+#define EXIBIR_BUFFER_MAX (8u << 20)    /* teto do buffer de saída (8 MB) */
+#define EXIBIR_INTERVALO_MIN 0.25       /* s entre quadros completos de mapas grandes */
+
+/* Oponentes automáticos (MCTS) */
+#define IA_MAX_JOGADAS 32               /* candidatos por nó (os de maior vantagem de tropas) */
+#define IA_PROFUNDIDADE 4               /* jogadas da IA representadas na árvore */
+#define IA_RODADAS_ROLLOUT 8            /* rodadas aleatórias (todas as cores) após a folha */
+#define IA_EXPLORACAO 1.4               /* constante do UCB1 */
+#define IA_ARENA_NOS (8u << 20)         /* bytes de nós da árvore por thread */
+#define IA_MAX_DIARIO (2 * (IA_PROFUNDIDADE + IA_RODADAS_ROLLOUT) * MAX_CORES)
+
+/* Lotes de ataques (resolverLoteAtaques) */
+#define LOTE_MIN_PARALELO 4096          /* ataques de uma onda abaixo dos quais não se divide entre threads */
+
+/* Turnos multijogador (--jogadores N): reforço recebido no início de cada turno */
+#define REFORCO_MINIMO 3                /* tropas mínimas por turno */
+#define REFORCO_DIVISOR 2               /* 1 tropa a cada REFORCO_DIVISOR territórios */
+#define TURNOS_MAX_RODADAS 100000       /* limite padrão de rodadas de --bench-turnos */
+
+/* Log binário de eventos (--log ARQ), lido offline por ./warlog */
+#define LOG_MAGICA "WARLOG"
+#define LOG_VERSAO 1
+#define LOG_ANEL_EVENTOS (1u << 18)     /* eventos por anel (um por thread); potência de 2 */
+#define LOG_INTERVALO_MS 10             /* período do gravador em segundo plano */
+#define LOG_PARTIDA   1     /* início de partida: a = territórios, b = cores */
+#define LOG_BATALHA   2     /* cor x outraCor; a = origem, b = destino, detalhe = dados */
+#define LOG_CONQUISTA 3     /* cor toma de outraCor o território a com b tropas */
+#define LOG_MISSAO    4     /* missão sorteada: detalhe = regra (tipo), a = alvoNumero, outraCor = alvoCor */
+#define LOG_VITORIA   5     /* cor venceu: detalhe = tipo da missão (LOG_SEM_MISSAO = por eliminação) */
+#define LOG_DESCARTE  6     /* a = eventos perdidos com o anel cheio (gravado no fechamento) */
+#define LOG_NUM_TIPOS 7
+#define LOG_SEM_MISSAO 0xFF
+
+/* Instrumentação (compilar com -DWAR_INSTRUMENTAR; sem a flag nada é gerado) */
+#define FASE_ATAQUE    0        /* faseDeAtaque */
+#define FASE_SIMULAR   1        /* simularAtaque */
+#define FASE_VALIDAR   2        /* validarAtaque */
+#define FASE_RESOLVER  3        /* resolverBatalha */
+#define FASE_VITORIA   4        /* verificarVitoria */
+#define FASE_SAIDA     5        /* renderizarMapa */
+#define FASE_PARTIDA   6        /* jogarPartidaAutomatica */
+#define NUM_FASES      7
+#define HIST_BATALHAS        0  /* batalhas por partida */
+#define HIST_CONQUISTAS      1  /* conquistas por partida */
+#define HIST_TRANSFERENCIAS  2  /* tropas transferidas por conquista */
+#define NUM_HISTOGRAMAS      3
+#define INSTR_BALDES 33         /* balde k: valores em [2^(k-1), 2^k) (balde 0 = zero) */
+#define INSTR_MAX_EVENTOS (1u << 16)    /* eventos de trace por thread; o excesso é descartado */
+
+/* Limite de ataques por partida automática (evita partidas sem fim) */
+#define MAX_ATAQUES_PARTIDA 10000
+
+/* --- Estrutura de Dados --- */
+/* Gerador de números aleatórios (xoshiro256**): estado pequeno, rápido e com
+   semente explícita. Cada thread/jogo usa o seu próprio gerador. */
+typedef struct {
+    uint64_t s[4];
+} GeradorAleatorio;
+
+/* Grafo de adjacência entre territórios em formato CSR (compressed sparse row):
+   os vizinhos do território i são vizinhos[inicio[i] .. inicio[i+1]-1].
+   Arestas não direcionadas aparecem nos dois sentidos. */
+typedef struct {
+    int n;                  /* número de nós (territórios) */
+    int64_t numEntradas;    /* tamanho de vizinhos[] (2x o número de arestas) */
+    int64_t *inicio;        /* n+1 deslocamentos */
+    int *vizinhos;          /* listas de adjacência concatenadas */
+} Grafo;
+
+/* Arena: um único bloco reservado uma vez; alocações avançam um cursor e
+   arenaReiniciar() devolve tudo em O(1). Usada para o estado de cada partida. */
+typedef struct {
+    uint8_t *base;
+    size_t capacidade;
+    size_t usado;
+} Arena;
+
+/* Componentes conexos de uma cor (territórios da mesma cor ligados por fronteira) */
+typedef struct {
+    int componentes;        /* número de componentes conexos */
+    int maior;              /* tamanho do maior componente */
+} ComponentesCor;
+
+/* Registro do diário de jogadas: estado de um território antes de uma mutação */
+typedef struct {
+    int idx;
+    uint8_t dono;           /* dono anterior */
+    int tropas;             /* tropas anteriores */
+} RegistroDiario;
+
+/* Diário de desfazer: pilha de RegistroDiario preenchida por
+   atualizarTerritorio() enquanto estiver ligado ao mapa. Um ataque gera um ou
+   dois registros; desfazerAte() volta a qualquer marca em O(registros desfeitos).
+   O buffer é do heap (cresce com memRealocar) ou fornecido pelo chamador (fixo). */
+typedef struct {
+    RegistroDiario *registros;
+    size_t qtd;
+    size_t capacidade;
+    int proprio;            /* 1 se 'registros' é do heap e pode crescer */
+    int incompleto;         /* 1 se faltou memória para crescer: há mutações sem registro */
+} Diario;
+
+/* Representa o mapa do jogo War em estrutura de vetores paralelos.
+   O território i é (dono[i], tropas[i]); o dono é um id pequeno da tabela de
+   cores internadas, então verificar posse é comparar inteiros. Os nomes são
+   dados frios e ficam em vetor separado (NULL = nome gerado "Territorio_i").
+   Os agregados por cor são mantidos incrementalmente: toda alteração de
+   dono/tropas depois da inicialização passa por aplicarMutacao() (nucleo.c),
+   via atualizarTerritorio() — que também anota cada mudança no diário, se
+   houver um ligado — ou via os lotes de ataques, que somam a diferença dos
+   agregados por thread e a aplicam ao mapa no fim do lote. */
+typedef struct {
+    int qtd;                        /* número de territórios */
+    uint8_t *dono;                  /* id da cor que domina cada território */
+    int *tropas;                    /* tropas em cada território */
+    char (*nomes)[TAM_NOME];        /* nomes (opcional) */
+    int numCores;                   /* cores internadas em cores[] */
+    char cores[MAX_CORES][TAM_COR]; /* nome de cada id de cor */
+    long long territoriosPorCor[MAX_CORES]; /* agregado: territórios de cada cor */
+    long long tropasPorCor[MAX_CORES];      /* agregado: soma das tropas de cada cor */
+    const Grafo *grafo;             /* fronteiras (NULL = todos se tocam); não pertence ao mapa */
+    Diario *diario;                 /* diário de desfazer (NULL = desligado); não pertence ao mapa */
+    int registrar;                  /* 1 = batalhas vão para o log de eventos (nunca nas cópias da IA) */
+} Mapa;
+
+/* Lance de um replay: o ataque e os dados sorteados. Reaplicar os lances com
+   resolverBatalha() sobre o estado inicial reproduz a partida exatamente. */
+typedef struct {
+    int origem, destino;
+    uint8_t dadoAtk, dadoDef;
+} LanceReplay;
+
+/* Resultado de uma única batalha resolvida pelo motor (sem E/S) */
+typedef struct {
+    int dadoAtk;            /* valor sorteado para o atacante (1..6) */
+    int dadoDef;            /* valor sorteado para o defensor (1..6) */
+    int conquistou;         /* 1 se o defensor foi conquistado */
+    int tropasTransferidas; /* tropas movidas para o território conquistado */
+} ResultadoBatalha;
+
+/* Desfecho de uma sequência de ataque: o atacante repete a batalha de
+   resolverBatalha() enquanto tiver ao menos 2 tropas ou até conquistar */
+typedef struct {
+    int conquistou;         /* 1 se o defensor foi conquistado */
+    int tropasAtk;          /* tropas finais no território atacante */
+    int tropasDef;          /* tropas finais no território defensor */
+    int batalhas;           /* batalhas (rolagens) da sequência */
+} DesfechoSequencia;
+
+/* Estatísticas acumuladas do modo em lote para um par (tropas atacante, tropas defensor) */
+typedef struct {
+    int tropasAtk;          /* tropas iniciais do atacante */
+    int tropasDef;          /* tropas iniciais do defensor */
+    long long amostras;     /* sequências de ataque simuladas */
+    long long conquistas;   /* sequências que terminaram em conquista */
+    long long batalhas;     /* total de batalhas (rolagens) executadas */
+    long long perdasAtk;    /* tropas perdidas pelo atacante */
+    long long perdasDef;    /* tropas perdidas pelo defensor */
+} EstatisticaPar;
+
+/* Resultado agregado de partidas automáticas (somado por thread e depois mesclado) */
+typedef struct {
+    long long partidas;     /* partidas jogadas */
+    long long vitorias;     /* partidas em que a missão foi cumprida */
+    long long ataques;      /* ataques (batalhas) executados */
+    long long conquistas;   /* territórios conquistados */
+    long long porTipo[MISSAO_MAX_REGRAS];   /* vitórias por regra de missão */
+} EstatisticaPartidas;
+
+/* Fila de partidas de um trabalhador do executor paralelo.
+   O intervalo [inicio, fim) fica empacotado em um único inteiro atômico
+   (inicio nos 32 bits altos), permitindo que o dono retire partidas do início
+   e que outras threads roubem metade do fim com um único compare-and-swap. */
+typedef struct {
+    _Atomic uint64_t intervalo;
+    char preenchimento[56]; /* evita falso compartilhamento entre trabalhadores */
+} FilaPartidas;
+
+/* Resultado de uma varredura do mapa: tudo que as missões precisam, em uma passada */
+typedef struct {
+    long long territorios;  /* territórios da cor do jogador */
+    long long tropas;       /* soma das tropas da cor do jogador */
+    int alvoPresente;       /* 1 se algum território pertence à cor alvo */
+} VarreduraCor;
+
+/* Assinatura dos kernels de varredura (escalar, SSE2, AVX2) */
+typedef void (*KernelVarredura)(const uint8_t *dono, const int *tropas, size_t n,
+                                uint8_t cor, uint8_t alvo, VarreduraCor *out);
+
+/* Parcela de uma quantidade de regra: multiplicador * territórios do mapa /
+   divisor + constante; com 'sorteio', um inteiro uniforme em [0, esse valor] */
+typedef struct {
+    int sorteio;
+    int multiplicador;
+    int divisor;
+    int constante;
+} ParcelaMissao;
+
+/* Modelo de um termo de regra, instanciado por sortearMissao() */
+typedef struct {
+    uint8_t campo;          /* MISSAO_CAMPO_* */
+    uint8_t alvo;           /* MISSAO_ALVO_* */
+    int8_t sinal;           /* +1 (>=) ou -1 (<=) */
+    int numParcelas;        /* quantidade = soma das parcelas */
+    ParcelaMissao parcelas[MISSAO_MAX_PARCELAS];
+} ModeloTermo;
+
+/* Regra de missão compilada: todos os termos precisam ser cumpridos */
+typedef struct {
+    char nome[24];
+    char descricao[120];    /* modelo: {1}..{4} = quantidade do termo, {cor} = cor alvo */
+    int numTermos;
+    ModeloTermo termos[MISSAO_MAX_TERMOS];
+} RegraMissao;
+
+/* Tabela de regras: a missão é sorteada uniformemente entre elas */
+typedef struct {
+    int numRegras;
+    RegraMissao regras[MISSAO_MAX_REGRAS];
+} TabelaMissoes;
+
+/* Termo de uma missão sorteada: cumprido se sinal * agregado[campo][cor] >= limiar.
+   "ao menos N territórios" vira (+1, N); "eliminar a cor" vira (-1, 0). */
+typedef struct {
+    int64_t limiar;
+    uint8_t campo;          /* MISSAO_CAMPO_* */
+    uint8_t cor;            /* id da cor ou MISSAO_COR_JOGADOR */
+    int8_t sinal;
+} TermoMissao;
+
+/* Estrutura para representar uma missão de jogador */
+typedef struct {
+    int tipo;               /* índice da regra na tabela de missões */
+    int alvoNumero;         /* quantidade do primeiro termo (exibição e log) */
+    int alvoCor;            /* cor alvo sorteada, ou COR_NENHUMA */
+    char descricao[120];    /* texto descritivo da missão */
+    int numTermos;          /* programa plano avaliado por verificarVitoria() */
+    TermoMissao termos[MISSAO_MAX_TERMOS];
+} Missao;
+
+/* Cabeçalho do snapshot binário. O arquivo é a imagem empacotada do mapa:
+   cabeçalho, depois as seções dono[], tropas[], nomes[], inicio[] e
+   vizinhos[] do grafo, cada uma alinhada a SNAPSHOT_ALINHAMENTO bytes e
+   localizada pelos deslocamentos abaixo. Tudo em formato nativo
+   (little-endian, int de 32 bits), para ser usado direto do mmap. A soma do
+   cabeçalho protege os agregados e os deslocamentos em toda abertura; a das
+   seções só é conferida na abertura com validação completa. */
+typedef struct {
+    char magica[8];                     /* "WARSNAP\0" */
+    uint32_t versao;                    /* SNAPSHOT_VERSAO */
+    uint32_t flags;                     /* SNAPSHOT_TEM_* */
+    int64_t qtd;                        /* número de territórios */
+    int32_t numCores;
+    int32_t corJogador;
+    char cores[MAX_CORES][TAM_COR];
+    int32_t missaoTipo;
+    int32_t missaoAlvoNumero;
+    int32_t missaoAlvoCor;
+    char missaoDescricao[120];
+    int32_t missaoNumTermos;
+    TermoMissao missaoTermos[MISSAO_MAX_TERMOS];
+    int64_t territoriosPorCor[MAX_CORES];   /* agregados salvos: abrir não varre o mapa */
+    int64_t tropasPorCor[MAX_CORES];
+    int64_t numEntradasGrafo;
+    uint64_t offDono, offTropas, offNomes, offInicio, offVizinhos;
+    uint64_t tamanhoTotal;              /* tamanho esperado do arquivo */
+    uint64_t somaSecoes;                /* somaSnapshot() das seções, em ordem */
+    uint64_t somaCabecalho;             /* somaSnapshot() do cabeçalho com este campo zerado */
+} CabecalhoSnapshot;
+
+/* Snapshot aberto: mapa, grafo e missão apontam para dentro do mapeamento.
+   O mapeamento é privado (copy-on-write): o jogo pode alterar o mapa sem
+   modificar o arquivo. */
+typedef struct {
+    void *base;                         /* início do mmap */
+    size_t tamanho;
+    Mapa mapa;
+    Grafo grafo;
+    Missao missao;
+    int temMissao;
+    int corJogador;
+} Snapshot;
+
+/* Renderizador do mapa: monta cada quadro em um buffer pré-alocado e o envia
+   ao terminal com uma única write(). Guarda uma cópia de dono/tropas do último
+   quadro para o modo de alterações. */
+typedef struct {
+    char *buf;
+    size_t capacidade;
+    size_t usado;
+    int modo;                           /* EXIBIR_* */
+    int pagina;                         /* página do modo resumo (base 0) */
+    int qtd;                            /* territórios cobertos pelo quadro anterior */
+    uint8_t *donoAnterior;
+    int *tropasAnterior;
+    int temAnterior;                    /* já houve um quadro? */
+    double ultimoCompleto;              /* instante do último quadro completo */
+} Renderizador;
+
+/* Configuração dos oponentes automáticos: orçamento por turno em segundos
+   ou, se iteracoes > 0, um número fixo de playouts (reprodutível). */
+typedef struct {
+    double orcamento;
+    long long iteracoes;
+    int threads;
+} ConfigIA;
+
+/* Oponentes de uma partida (arenas, cópias do mapa e threads da busca),
+   criados por criarContextoIA() e reaproveitados a cada decisão. */
+typedef struct ContextoIA ContextoIA;
+
+/* Jogada escolhida pela IA e o esforço gasto para escolhê-la */
+typedef struct {
+    int origem, destino;
+    double valor;           /* recompensa média estimada da jogada (0..1) */
+    long long playouts;     /* somados entre as threads */
+    int threads;
+    double segundos;
+} DecisaoIA;
+
+/* Lote de ataques simultâneos para resolverLoteAtaques(). O chamador
+   preenche n, origens[] e destinos[]; os demais vetores são saída ou memória
+   de trabalho, alocados uma vez por criarLoteAtaques() e reutilizados.
+   Os ataques são agrupados em ondas: um ataque vai para a onda seguinte à
+   última que tocou sua origem ou seu destino, então os ataques de uma onda
+   não compartilham territórios e podem ser resolvidos em qualquer ordem —
+   e ataques em conflito ficam na ordem do lote. */
+typedef struct {
+    int capacidade;                     /* máximo de ataques por lote */
+    int qtdTerritorios;                 /* tamanho de ultimaOnda[] */
+    int n;                              /* ataques no lote atual */
+    int *origens, *destinos;            /* entrada */
+    ResultadoBatalha *resultados;       /* saída: dados e desfecho de cada ataque */
+    uint8_t *codigos;                   /* saída: ATAQUE_* de cada ataque, na hora em que foi resolvido */
+    int numOndas;                       /* saída: ondas do último lote */
+    uint64_t *brutos;                   /* 2 por ataque: saídas cruas do gerador */
+    uint8_t *dados;                     /* 2 por ataque: dado do atacante, dado do defensor */
+    int *onda;                          /* onda de cada ataque (1..numOndas) */
+    int *ordem;                         /* ataques agrupados por onda, na ordem do lote */
+    int *inicioOnda;                    /* numOndas+1 deslocamentos em ordem[] */
+    int *ultimaOnda;                    /* por território: última onda que o tocou (0 = nenhuma) */
+} LoteAtaques;
+
+/* Escalonador de turnos de até MAX_CORES jogadores. A rotação guarda só as
+   cores ainda vivas, compactadas em ordem[]; o resto do estado por jogador
+   fica em vetores pequenos indexados pelo id da cor. Reforço e eliminação
+   consultam os agregados do mapa (territoriosPorCor), então avançar uma
+   rodada custa O(jogadores), e não O(territórios). */
+typedef struct {
+    int numJogadores;                   /* jogadores ainda na rotação */
+    int vez;                            /* posição em ordem[] do jogador da vez */
+    long long rodada;                   /* rodada atual (começa em 1) */
+    int corHumana;                      /* cor do usuário (COR_NENHUMA = todos automáticos) */
+    uint8_t ordem[MAX_CORES];           /* ids das cores vivas, na ordem de jogo */
+    int ancora[MAX_CORES];              /* por cor: território onde cai o reforço sem ataque (-1 = procurar) */
+    long long eliminadoNaRodada[MAX_CORES]; /* por cor: rodada da eliminação (0 = vivo) */
+} Turnos;
+
+/* Evento do log binário: 16 bytes, gravado como está (little-endian).
+   O significado de a/b/detalhe depende do tipo (LOG_*). */
+typedef struct {
+    uint8_t tipo;                       /* LOG_* */
+    uint8_t cor;                        /* quem age: atacante, jogador, vencedor */
+    uint8_t outraCor;                   /* defensor ou cor alvo (COR_NENHUMA se não houver) */
+    uint8_t detalhe;                    /* batalha: dadoAtk << 4 | dadoDef; missão/vitória: tipo */
+    uint32_t partida;                   /* partida a que o evento pertence */
+    int32_t a, b;
+} EventoLog;
+
+/* Arquivo de log: CabecalhoLog e depois blocos, cada um com um BlocoLog
+   seguido de 'qtd' EventoLog de uma mesma thread (na ordem em que ela os
+   gerou). Blocos de threads diferentes se intercalam. */
+typedef struct {
+    char magica[8];                     /* "WARLOG\0" */
+    uint32_t versao;                    /* LOG_VERSAO */
+    uint32_t tamEvento;                 /* sizeof(EventoLog) */
+} CabecalhoLog;
+
+typedef struct {
+    uint32_t thread;                    /* id da thread no log (0, 1, ...) */
+    uint32_t qtd;                       /* eventos no bloco */
+} BlocoLog;
+
+/* Escopo instrumentado: aberto por INSTR_ESCOPO e fechado automaticamente
+   (atributo cleanup) em qualquer saída do bloco, inclusive returns antecipados. */
+typedef struct {
+    int fase;
+    uint64_t inicio;
+} EscopoInstr;
+
+#ifdef WAR_INSTRUMENTAR
+#define INSTR_ESCOPO(fase) \
+    EscopoInstr instrEscopo __attribute__((cleanup(instrFecharEscopo))) = { (fase), instrRelogio() }
+#define INSTR_HISTOGRAMA(hist, valor) instrHistograma((hist), (uint64_t) (valor))
+#define INSTR_CONFIGURAR(argc, argv) instrConfigurar((argc), (argv))
+#else
+#define INSTR_ESCOPO(fase) ((void) 0)
+#define INSTR_HISTOGRAMA(hist, valor) ((void) 0)
+#define INSTR_CONFIGURAR(argc, argv) ((void) 0)
+#endif
+
+/* --- Protótipos das Funções --- */
+
+/* Funções do gerador de números aleatórios */
+void rngSemear(GeradorAleatorio *rng, uint64_t semente);
+void rngSemearFluxo(GeradorAleatorio *rng, uint64_t semente, uint64_t fluxo);
+void rngSaltar(GeradorAleatorio *rng);
+GeradorAleatorio rngDividir(GeradorAleatorio *rng);
+uint64_t rngProximo(GeradorAleatorio *rng);
+uint32_t rngIntervalo(GeradorAleatorio *rng, uint32_t n);
+int rngDado(GeradorAleatorio *rng);
+
+/* Funções de setup e gerenciamento de memória */
+void* memAlocar(size_t tam);
+void* memAlocarZerado(size_t n, size_t tam);
+void* memRealocar(void *ptr, size_t tam);
+long long alocacoesHeap(void);
+int arenaCriar(Arena *arena, size_t capacidade);
+void* arenaAlocar(Arena *arena, size_t tam);
+size_t arenaMarca(const Arena *arena);
+void arenaRestaurar(Arena *arena, size_t marca);
+void arenaReiniciar(Arena *arena);
+void arenaDestruir(Arena *arena);
+size_t tamanhoArenaPartida(int qtd, int comNomes);
+Mapa* alocarMapa(int qtd, int comNomes);
+Mapa* alocarMapaArena(Arena *arena, int qtd, int comNomes);
+void inicializarTerritorios(Mapa *mapa, char cores[][TAM_COR], int numCores, GeradorAleatorio *rng);
+void liberarMemoria(Mapa *mapa, Missao *missao);
+int internarCor(Mapa *mapa, const char *cor);
+const char* nomeTerritorio(const Mapa *mapa, int idx, char *buf, size_t tam);
+void atualizarTerritorio(Mapa *mapa, int idx, int dono, int tropas);
+void recalcularAgregados(Mapa *mapa);
+int diarioCriar(Diario *diario, size_t capacidade);
+void diarioUsarBuffer(Diario *diario, RegistroDiario *buf, size_t capacidade);
+void diarioLiberar(Diario *diario);
+size_t diarioMarca(const Diario *diario);
+void desfazerAte(Mapa *mapa, size_t marca);
+int executarBenchDiario(int argc, char *argv[]);
+void conferirAgregados(const Mapa *mapa);
+int corEliminada(const Mapa *mapa, int cor);
+
+/* Funções de interface com o usuário */
+void exibirMenuPrincipal(void);
+void exibirMapa(const Mapa *mapa);
+int criarRenderizador(Renderizador *r, const Mapa *mapa, int modo);
+void destruirRenderizador(Renderizador *r);
+void renderizarMapa(Renderizador *r, const Mapa *mapa);
+void exibirMissao(const Missao *missao);
+void exibirVerificacao(int cumprida);
+
+/* Funções de lógica principal do jogo */
+void faseDeAtaque(Mapa *mapa, int corJogador, GeradorAleatorio *rng);
+int executarAtaqueJogador(Mapa *mapa, int corJogador, int idxOrigem, int idxDestino,
+                          GeradorAleatorio *rng, int verboso);
+void simularAtaque(Mapa *mapa, int idxAtacante, int idxDefensor, GeradorAleatorio *rng);
+void resolverBatalha(Mapa *mapa, int idxAtacante, int idxDefensor, int dadoAtk, int dadoDef, ResultadoBatalha *res);
+int criarLoteAtaques(LoteAtaques *lote, int capacidade, int qtdTerritorios);
+void destruirLoteAtaques(LoteAtaques *lote);
+int resolverLoteAtaques(Mapa *mapa, LoteAtaques *lote, GeradorAleatorio *rng, int threads);
+int resolverAtaquesEmSerie(Mapa *mapa, LoteAtaques *lote, GeradorAleatorio *rng);
+size_t gerarDados(GeradorAleatorio *rng, uint8_t *dados, uint64_t *brutos, size_t n);
+int executarBenchLote(int argc, char *argv[]);
+Missao* sortearMissao(const Mapa *mapa, int corJogador, GeradorAleatorio *rng, Arena *arena);
+void montarMissaoPadrao(Missao *missao, int tipo, int alvoNumero, int alvoCor);
+int verificarVitoria(const Mapa *mapa, const Missao *missao, int corJogador);
+int verificarMissoes(const Mapa *mapa, const Missao *missoes, const uint8_t *cores, int n, uint8_t *cumpridas);
+int validarAtaque(const Mapa *mapa, int idxOrigem, int idxDestino, int corJogador);
+
+/* Grafo de adjacência (CSR) e consultas de topologia */
+Grafo* construirGrafo(int n, const int *origens, const int *destinos, int64_t numArestas);
+Grafo* gerarGrafoGrade(int n);
+Grafo* gerarGrafoAleatorio(int n, int grauMedio, GeradorAleatorio *rng);
+void liberarGrafo(Grafo *grafo);
+int saoVizinhos(const Mapa *mapa, int a, int b);
+int escolherVizinhoInimigo(const Mapa *mapa, int idx, int cor, GeradorAleatorio *rng);
+int listarFronteira(const Mapa *mapa, int cor, int *saida);
+int analisarComponentes(const Mapa *mapa, ComponentesCor saida[MAX_CORES], Arena *rascunho);
+int executarBenchGrafo(int argc, char *argv[]);
+
+/* Snapshot binário: salvar com uma escrita, abrir com mmap */
+int salvarSnapshot(const char *caminho, const Mapa *mapa, const Missao *missao, int corJogador);
+int carregarSnapshot(const char *caminho, Snapshot *snap, int validar);
+void fecharSnapshot(Snapshot *snap);
+int executarGerarSnapshot(int argc, char *argv[]);
+
+/* Modo de comandos: roteiro lido de uma vez e interpretado sem cópias */
+int executarComandos(const char *caminho, Mapa *mapa, const Missao *missao, int corJogador,
+                     Turnos *turnos, GeradorAleatorio *rng, ContextoIA *ia, int eco);
+
+/* Oponentes automáticos: busca em árvore Monte Carlo */
+ContextoIA* criarContextoIA(const Mapa *mapa, const ConfigIA *cfg);
+void destruirContextoIA(ContextoIA *ia);
+int escolherJogadaIA(ContextoIA *ia, const Mapa *mapa, int cor, uint64_t semente, DecisaoIA *decisao);
+void executarTurnosIA(Mapa *mapa, int corJogador, ContextoIA *ia, GeradorAleatorio *rng);
+int executarBenchIA(int argc, char *argv[]);
+
+/* Turnos multijogador: reforço, rotação e eliminação */
+void iniciarTurnos(Turnos *t, const Mapa *mapa, int corHumana);
+int jogadorDaVez(const Turnos *t);
+int avancarTurno(Turnos *t, const Mapa *mapa, int *eliminadas);
+int calcularReforco(const Mapa *mapa, int cor);
+int reforcarTerritorio(Mapa *mapa, int cor, int idx, int tropas);
+int territorioDeReforco(const Mapa *mapa, Turnos *t, int cor);
+void faseDeReforco(Mapa *mapa, Turnos *t, int cor);
+int jogarTurnoAutomatico(Mapa *mapa, Turnos *t, int cor, ContextoIA *ia, GeradorAleatorio *rng, int verboso);
+int executarTurnosAutomaticos(Mapa *mapa, Turnos *t, ContextoIA *ia, GeradorAleatorio *rng, int verboso);
+int executarBenchTurnos(int argc, char *argv[]);
+
+/* Kernels de varredura usados por verificarVitoria() (escolhidos em tempo de execução) */
+void varrerCorEscalar(const uint8_t *dono, const int *tropas, size_t n, uint8_t cor, uint8_t alvo, VarreduraCor *out);
+void varrerCorSSE2(const uint8_t *dono, const int *tropas, size_t n, uint8_t cor, uint8_t alvo, VarreduraCor *out);
+void varrerCorAVX2(const uint8_t *dono, const int *tropas, size_t n, uint8_t cor, uint8_t alvo, VarreduraCor *out);
+KernelVarredura escolherKernelVarredura(const char **nome);
+void varrerMapa(const Mapa *mapa, int cor, int alvo, VarreduraCor *out);
+int executarBenchVitoria(int argc, char *argv[]);
+
+/* Motor de simulação em lote (sem E/S no laço interno) */
+void simularSequenciaAtaque(int tropasAtk, int tropasDef, long long amostras, EstatisticaPar *est, GeradorAleatorio *rng);
+void simularSequenciaTabela(int tropasAtk, int tropasDef, long long amostras, EstatisticaPar *est, GeradorAleatorio *rng);
+
+/* Tabela de desfechos (cadeia de Markov das sequências de ataque) */
+void inicializarTabelaBatalha(void);
+double probabilidadeConquista(int tropasAtk, int tropasDef);
+double perdaEsperadaAtacante(int tropasAtk, int tropasDef);
+void desfechoPorPerdas(int tropasAtk, int tropasDef, int perdas, DesfechoSequencia *out);
+void amostrarSequencia(int tropasAtk, int tropasDef, GeradorAleatorio *rng, DesfechoSequencia *out);
+int executarModoLote(int argc, char *argv[]);
+
+/* Executor paralelo de partidas completas */
+int escolherAtaqueAleatorio(const Mapa *mapa, int corJogador, GeradorAleatorio *rng, int *idxOrigem, int *idxDestino);
+void jogarPartidaAutomatica(Mapa *mapa, char cores[][TAM_COR], int numCores, GeradorAleatorio *rng,
+                            Arena *arena, EstatisticaPartidas *est);
+int executarModoPartidas(int argc, char *argv[]);
+
+/* Tabela de missões: regras compiladas de texto */
+int compilarMissoes(const char *texto, size_t tam, const char *origem, TabelaMissoes *tabela);
+int carregarMissoes(const char *caminho);
+const TabelaMissoes* tabelaMissoes(void);
+int executarBenchMissoes(int argc, char *argv[]);
+
+/* Log binário de eventos: anéis por thread e gravação assíncrona */
+int logAbrir(const char *caminho);
+void logFechar(void);
+int logAtivo(void);
+void logPartida(uint32_t partida);
+void logEvento(int tipo, int cor, int outraCor, int detalhe, int32_t a, int32_t b);
+void registrarInicioPartida(const Mapa *mapa);
+void registrarMissao(const Mapa *mapa, int cor, const Missao *missao);
+void registrarVitoria(const Mapa *mapa, int cor, const Missao *missao);
+
+/* Instrumentação: contadores por fase, histogramas e trace por thread */
+uint64_t instrRelogio(void);
+void instrFecharEscopo(EscopoInstr *escopo);
+void instrHistograma(int hist, uint64_t valor);
+void instrConfigurar(int argc, char *argv[]);
+void instrRelatorio(FILE *saida);
+int instrSalvarTrace(const char *caminho);
+
+/* Função utilitária */
+void limparBufferEntrada(void);
+double segundosMonotonicos(void);
+long long lerOpcaoInteira(int argc, char *argv[], const char *nome, long long padrao);
+int temOpcao(int argc, char *argv[], const char *nome);
+const char* lerOpcaoTexto(int argc, char *argv[], const char *nome, const char *padrao);
+
+#endif /* WAR_H */
@@ -0,0 +1,284 @@
+/*
+   warlog.c - leitor offline do log binário de eventos do PROJETO WAR ESTRUTURADO.
+
+   Uso: warlog ARQ [--listar N] [--missoes ARQ]
+
+   Lê o log gravado com "war ... --log ARQ" em fluxo (um buffer fixo, sem
+   carregar o arquivo), então serve para logs de vários GB. Imprime:
+   - eventos por tipo, blocos e threads;
+   - partidas, batalhas por partida e taxa de conquista;
+   - frequência observada de cada par de dados (ATK x DEF);
+   - conquistas e territórios perdidos por cor;
+   - missões sorteadas e vitórias por tipo de missão;
+   - eventos descartados pelo jogo (anel cheio).
+   Com --listar N, imprime antes os N primeiros eventos decodificados.
+   As missões são nomeadas pela tabela padrão ou, com --missoes ARQ, pelas
+   regras do arquivo usado no jogo (o log guarda só o índice da regra).
+*/
+
+#include "war.h"
+
+#define WARLOG_BUFFER (4u << 20)
+
+/* Leitura em fluxo: o buffer guarda [ini, fim) ainda não consumidos */
+typedef struct {
+    int fd;
+    uint8_t *buf;
+    size_t ini, fim;
+    unsigned long long bytes;           /* lidos do arquivo */
+} LeitorLog;
+
+/* Estatísticas acumuladas do log */
+typedef struct {
+    unsigned long long eventos[LOG_NUM_TIPOS];
+    unsigned long long blocos, desconhecidos, descartados;
+    uint32_t threads;
+    unsigned long long dados[6][6];     /* batalhas por (dadoAtk, dadoDef) */
+    unsigned long long tropasTransferidas;
+    unsigned long long conquistasPorCor[MAX_CORES];
+    unsigned long long perdasPorCor[MAX_CORES];
+    unsigned long long missoesPorTipo[MISSAO_MAX_REGRAS];
+    unsigned long long vitoriasPorTipo[MISSAO_MAX_REGRAS + 1];  /* último = por eliminação (LOG_SEM_MISSAO) */
+} EstatisticaLog;
+
+static const char *nomesTipos[LOG_NUM_TIPOS] = {
+    "?", "partida", "batalha", "conquista", "missao", "vitoria", "descarte"
+};
+
+/* nomeMissao():
+   Nome da regra de índice 'detalhe' na tabela de missões ("eliminação" para
+   LOG_SEM_MISSAO, "regra N" fora da tabela).
+*/
+static const char* nomeMissao(int detalhe, char *buf, size_t tam) {
+    const TabelaMissoes *tabela = tabelaMissoes();
+    if (detalhe == LOG_SEM_MISSAO || detalhe == MISSAO_MAX_REGRAS) return "eliminação";
+    if (detalhe < tabela->numRegras) return tabela->regras[detalhe].nome;
+    snprintf(buf, tam, "regra %d", detalhe);
+    return buf;
+}
+
+/* garantirBytes():
+   Deixa pelo menos n bytes contíguos no buffer, movendo o resto para o
+   início e lendo mais do arquivo. Retorna 1, ou 0 se o arquivo acabou antes.
+*/
+static int garantirBytes(LeitorLog *l, size_t n) {
+    if (l->fim - l->ini >= n) return 1;
+    memmove(l->buf, l->buf + l->ini, l->fim - l->ini);
+    l->fim -= l->ini;
+    l->ini = 0;
+    while (l->fim < n) {
+        ssize_t lidos = read(l->fd, l->buf + l->fim, WARLOG_BUFFER - l->fim);
+        if (lidos <= 0) return 0;
+        l->fim += (size_t) lidos;
+        l->bytes += (unsigned long long) lidos;
+    }
+    return 1;
+}
+
+/* imprimirEvento():
+   Uma linha legível por evento (para --listar).
+*/
+static void imprimirEvento(uint32_t thread, const EventoLog *e) {
+    char nome[24];
+    printf("[t%u p%u] %-10s ", thread, e->partida, e->tipo < LOG_NUM_TIPOS ? nomesTipos[e->tipo] : "?");
+    switch (e->tipo) {
+        case LOG_PARTIDA:
+            printf("%d territórios, %d cores\n", e->a, e->b);
+            break;
+        case LOG_BATALHA:
+            printf("cor %d (%d) x cor %d (%d): dados %d x %d\n", e->cor, e->a, e->outraCor, e->b,
+                   e->detalhe >> 4, e->detalhe & 0xF);
+            break;
+        case LOG_CONQUISTA:
+            printf("cor %d toma %d da cor %d com %d tropas\n", e->cor, e->a, e->outraCor, e->b);
+            break;
+        case LOG_MISSAO:
+            printf("cor %d: %s (número %d, cor alvo %d)\n", e->cor,
+                   nomeMissao(e->detalhe, nome, sizeof(nome)), e->a, e->outraCor);
+            break;
+        case LOG_VITORIA:
+            printf("cor %d: %s (%d territórios, %d tropas)\n", e->cor,
+                   nomeMissao(e->detalhe, nome, sizeof(nome)), e->a, e->b);
+            break;
+        case LOG_DESCARTE:
+            printf("%llu eventos perdidos\n", (unsigned long long) e->a + ((unsigned long long) e->b << 31));
+            break;
+        default:
+            printf("\n");
+            break;
+    }
+}
+
+/* acumularEvento():
+   Soma um evento às estatísticas (ids fora da faixa são só contados).
+*/
+static void acumularEvento(EstatisticaLog *est, const EventoLog *e) {
+    if (e->tipo >= LOG_NUM_TIPOS) {
+        est->desconhecidos++;
+        return;
+    }
+    est->eventos[e->tipo]++;
+    switch (e->tipo) {
+        case LOG_BATALHA: {
+            int atk = (e->detalhe >> 4) - 1, def = (e->detalhe & 0xF) - 1;
+            if (atk >= 0 && atk < 6 && def >= 0 && def < 6) est->dados[atk][def]++;
+            break;
+        }
+        case LOG_CONQUISTA:
+            est->tropasTransferidas += (unsigned long long) e->b;
+            if (e->cor < MAX_CORES) est->conquistasPorCor[e->cor]++;
+            if (e->outraCor < MAX_CORES) est->perdasPorCor[e->outraCor]++;
+            break;
+        case LOG_MISSAO:
+            if (e->detalhe < MISSAO_MAX_REGRAS) est->missoesPorTipo[e->detalhe]++;
+            break;
+        case LOG_VITORIA:
+            if (e->detalhe < MISSAO_MAX_REGRAS) est->vitoriasPorTipo[e->detalhe]++;
+            else if (e->detalhe == LOG_SEM_MISSAO) est->vitoriasPorTipo[MISSAO_MAX_REGRAS]++;
+            break;
+        case LOG_DESCARTE:
+            est->descartados += (unsigned long long) e->a + ((unsigned long long) e->b << 31);
+            break;
+        default:
+            break;
+    }
+}
+
+/* lerLog():
+   Percorre os blocos do log acumulando em 'est' e listando os 'listar'
+   primeiros eventos. Retorna 0, ou 1 se o arquivo estiver truncado ou inválido.
+*/
+static int lerLog(LeitorLog *l, EstatisticaLog *est, long long listar) {
+    CabecalhoLog cab;
+    if (!garantirBytes(l, sizeof(cab))) {
+        fprintf(stderr, "Arquivo vazio ou truncado.\n");
+        return 1;
+    }
+    memcpy(&cab, l->buf + l->ini, sizeof(cab));
+    l->ini += sizeof(cab);
+    if (memcmp(cab.magica, LOG_MAGICA, sizeof(LOG_MAGICA)) != 0 || cab.versao != LOG_VERSAO ||
+        cab.tamEvento != sizeof(EventoLog)) {
+        fprintf(stderr, "Não é um log de eventos do WAR (versão %d).\n", LOG_VERSAO);
+        return 1;
+    }
+
+    while (garantirBytes(l, sizeof(BlocoLog))) {
+        BlocoLog bloco;
+        memcpy(&bloco, l->buf + l->ini, sizeof(bloco));
+        l->ini += sizeof(bloco);
+        est->blocos++;
+        if (bloco.thread >= est->threads) est->threads = bloco.thread + 1;
+
+        /* os eventos do bloco são consumidos em pedaços que cabem no buffer */
+        for (uint32_t restantes = bloco.qtd; restantes > 0; ) {
+            uint32_t pedaco = restantes < WARLOG_BUFFER / sizeof(EventoLog) / 2
+                ? restantes : (uint32_t) (WARLOG_BUFFER / sizeof(EventoLog) / 2);
+            if (!garantirBytes(l, (size_t) pedaco * sizeof(EventoLog))) {
+                fprintf(stderr, "Log truncado no bloco %llu.\n", est->blocos);
+                return 1;
+            }
+            for (uint32_t k = 0; k < pedaco; ++k) {
+                EventoLog e;
+                memcpy(&e, l->buf + l->ini + (size_t) k * sizeof(EventoLog), sizeof(e));
+                acumularEvento(est, &e);
+                if (listar > 0) {
+                    imprimirEvento(bloco.thread, &e);
+                    listar--;
+                }
+            }
+            l->ini += (size_t) pedaco * sizeof(EventoLog);
+            restantes -= pedaco;
+        }
+    }
+    if (l->fim != l->ini) {
+        fprintf(stderr, "Log truncado: %zu bytes sobrando no fim.\n", l->fim - l->ini);
+        return 1;
+    }
+    return 0;
+}
+
+/* imprimirEstatisticas():
+   Relatório agregado do log.
+*/
+static void imprimirEstatisticas(const EstatisticaLog *est, unsigned long long bytes, double segundos) {
+    unsigned long long total = est->desconhecidos;
+    for (int t = 0; t < LOG_NUM_TIPOS; ++t) total += est->eventos[t];
+
+    printf("=== LOG DE EVENTOS (%.1f MB, %llu eventos em %llu blocos, %u thread(s)) ===\n",
+           (double) bytes / 1e6, total, est->blocos, est->threads);
+    printf("Leitura: %.3f s (%.0f MB/s, %.1f milhões de eventos/s)\n", segundos,
+           segundos > 0 ? (double) bytes / 1e6 / segundos : 0.0,
+           segundos > 0 ? (double) total / 1e6 / segundos : 0.0);
+    for (int t = 1; t < LOG_NUM_TIPOS; ++t)
+        printf("  %-10s %llu\n", nomesTipos[t], est->eventos[t]);
+    if (est->desconhecidos) printf("  %-10s %llu\n", "desconh.", est->desconhecidos);
+
+    unsigned long long partidas = est->eventos[LOG_PARTIDA], batalhas = est->eventos[LOG_BATALHA];
+    unsigned long long conquistas = est->eventos[LOG_CONQUISTA];
+    printf("\nPartidas: %llu | batalhas/partida: %.2f | conquistas/partida: %.2f\n", partidas,
+           partidas ? (double) batalhas / (double) partidas : 0.0,
+           partidas ? (double) conquistas / (double) partidas : 0.0);
+    printf("Taxa de conquista: %.4f (teórica 15/36 = %.4f) | tropas por conquista: %.2f\n",
+           batalhas ? (double) conquistas / (double) batalhas : 0.0, 15.0 / 36.0,
+           conquistas ? (double) est->tropasTransferidas / (double) conquistas : 0.0);
+
+    if (batalhas) {
+        printf("\nFrequência de cada par de dados (ATK x DEF, esperado %.4f):\n", 1.0 / 36.0);
+        printf("ATK\\DEF");
+        for (int d = 0; d < 6; ++d) printf(" %-8d", d + 1);
+        printf("\n");
+        for (int a = 0; a < 6; ++a) {
+            printf("%-7d", a + 1);
+            for (int d = 0; d < 6; ++d) printf(" %-8.4f", (double) est->dados[a][d] / (double) batalhas);
+            printf("\n");
+        }
+    }
+
+    printf("\n%-6s %-14s %-14s\n", "COR", "CONQUISTAS", "PERDAS");
+    for (int c = 0; c < MAX_CORES; ++c)
+        if (est->conquistasPorCor[c] || est->perdasPorCor[c])
+            printf("%-6d %-14llu %-14llu\n", c, est->conquistasPorCor[c], est->perdasPorCor[c]);
+
+    printf("\n%-12s %-10s %-10s %-8s\n", "MISSÃO", "SORTEADAS", "VITÓRIAS", "TAXA");
+    for (int m = 0; m <= MISSAO_MAX_REGRAS; ++m) {
+        char nome[24];
+        unsigned long long sorteadas = m < MISSAO_MAX_REGRAS ? est->missoesPorTipo[m] : 0;
+        if (!sorteadas && !est->vitoriasPorTipo[m]) continue;
+        printf("%-12s %-10llu %-10llu ", nomeMissao(m, nome, sizeof(nome)), sorteadas, est->vitoriasPorTipo[m]);
+        if (sorteadas) printf("%.4f\n", (double) est->vitoriasPorTipo[m] / (double) sorteadas);
+        else printf("-\n");
+    }
+    if (est->descartados)
+        printf("\nAtenção: o jogo descartou %llu evento(s) com o anel cheio.\n", est->descartados);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2 || argv[1][0] == '-') {
+        fprintf(stderr, "Uso: %s ARQ [--listar N] [--missoes ARQ]\n", argv[0]);
+        return 1;
+    }
+    long long listar = lerOpcaoInteira(argc, argv, "--listar", 0);
+    const char *arquivoMissoes = lerOpcaoTexto(argc, argv, "--missoes", NULL);
+    if (arquivoMissoes && carregarMissoes(arquivoMissoes) != 0) return 1;
+
+    LeitorLog leitor = { open(argv[1], O_RDONLY), (uint8_t*) malloc(WARLOG_BUFFER), 0, 0, 0 };
+    if (leitor.fd < 0 || !leitor.buf) {
+        perror("Falha ao abrir o log");
+        if (leitor.fd >= 0) close(leitor.fd);
+        free(leitor.buf);
+        return 1;
+    }
+    posix_fadvise(leitor.fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    EstatisticaLog est;
+    memset(&est, 0, sizeof(est));
+    double inicio = segundosMonotonicos();
+    int erro = lerLog(&leitor, &est, listar);
+    double decorrido = segundosMonotonicos() - inicio;
+    if (listar > 0) printf("\n");
+    imprimirEstatisticas(&est, leitor.bytes, decorrido);
+
+    close(leitor.fd);
+    free(leitor.buf);
+    return erro;
+}